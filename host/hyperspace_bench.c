@@ -0,0 +1,266 @@
+/*
+ * Hyperspace Host Benchmark
+ * Runs the shared game core headlessly on a desktop
+ *
+ * Builds hyperspace_game.h + pico8_api.h + libfixmath natively, plays a
+ * scripted input sequence from a fixed rnd_state and reports per-phase
+ * timings, triangle/pixel counters and a checksum of screen[][]. The same
+ * PROF_* hooks as the device profiler are used, backed by the host clock.
+ *
+ * Usage:
+ *   hyperspace_bench [frames] [seed]    (defaults: 3000 frames, seed 1)
+ *
+ * The checksum only depends on the game core, so two builds that print the
+ * same value rendered every frame identically.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+
+#include "thumbycolor_profiler.h"
+#include "libfixmath/fixmath.h"
+
+#define SCREEN_WIDTH  128
+#define SCREEN_HEIGHT 128
+
+#include "pico8_api.h"
+
+// =============================================================================
+// Platform State Expected by hyperspace_game.h
+// =============================================================================
+
+static uint32_t rnd_state = 1;
+
+static bool btn_state[6] = {false};
+static bool btn_prev[6] = {false};
+
+static int32_t cart_data[64] = {0};
+static bool cart_data_dirty = false;
+
+static void load_cart_data(void) {
+}
+
+static void save_cart_data(void) {
+    cart_data_dirty = false;
+}
+
+#define FIX_HALF F16(0.5)
+#define FIX_TWO F16(2.0)
+#define FIX_PI fix16_pi
+#define FIX_TWO_PI F16(6.28318530718)
+#define FIX_SCREEN_CENTER F16(64.0)  // 128/2
+#define FIX_PROJ_CONST F16(-80.0)    // Projection constant for 128px
+
+#include "hyperspace_data.h"
+#include "hyperspace_game.h"
+
+// =============================================================================
+// Profiler Backend (host clock)
+// =============================================================================
+
+static const char* const phase_names[PROF_NUM_PHASES] = {
+    "update", "transform", "background", "enemies", "lasers", "ship", "hud",
+    "present", "present_wait", "vsync"
+};
+
+uint32_t profiler_counters[PROF_NUM_COUNTERS];
+
+static uint64_t phase_start[PROF_NUM_PHASES];
+static uint64_t phase_ns[PROF_NUM_PHASES];
+static uint64_t total_counters[PROF_NUM_COUNTERS];
+static uint32_t last_counters[PROF_NUM_COUNTERS];
+static uint64_t frame_start_ns, last_frame_ns;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void profiler_init(void) {
+    memset(phase_ns, 0, sizeof(phase_ns));
+    memset(profiler_counters, 0, sizeof(profiler_counters));
+    memset(total_counters, 0, sizeof(total_counters));
+    frame_start_ns = now_ns();
+}
+
+void profiler_begin(profiler_phase_t phase) {
+    phase_start[phase] = now_ns();
+}
+
+// Totals over the whole run (the device build keeps per-frame values)
+void profiler_end(profiler_phase_t phase) {
+    phase_ns[phase] += now_ns() - phase_start[phase];
+}
+
+void profiler_frame_end(void) {
+    uint64_t now = now_ns();
+    last_frame_ns = now - frame_start_ns;
+    frame_start_ns = now;
+    for (int i = 0; i < PROF_NUM_COUNTERS; i++) {
+        last_counters[i] = profiler_counters[i];
+        total_counters[i] += profiler_counters[i];
+        profiler_counters[i] = 0;
+    }
+}
+
+uint32_t profiler_frame_us(void) {
+    return (uint32_t)(last_frame_ns / 1000);
+}
+
+uint32_t profiler_phase_us(profiler_phase_t phase) {
+    return (uint32_t)(phase_ns[phase] / 1000);
+}
+
+uint32_t profiler_count(profiler_counter_t counter) {
+    return last_counters[counter];
+}
+
+const char* profiler_phase_name(profiler_phase_t phase) {
+    return phase_names[phase];
+}
+
+// =============================================================================
+// Scripted Input
+// =============================================================================
+
+// Title: open the options twice with B, then start with A. In game: fire
+// held, direction re-rolled every 16 frames, occasional barrel roll.
+static void bench_buttons(int frame) {
+    static uint32_t input_state = 1;
+    bool b[6] = {false};
+
+    if (frame == 30 || frame == 60) {
+        b[5] = true;
+    } else if (frame >= 90) {
+        if ((frame & 15) == 0) input_state = input_state * 1103515245u + 12345u;
+        uint32_t r = input_state >> 16;
+        b[4] = true;
+        if (r & 1) b[0] = true; else if (r & 2) b[1] = true;
+        if (r & 4) b[2] = true; else if (r & 8) b[3] = true;
+        if ((r & 0x1F0) == 0x40) b[5] = true;
+    }
+
+    for (int i = 0; i < 6; i++) {
+        btn_prev[i] = btn_state[i];
+        btn_state[i] = b[i];
+    }
+}
+
+// =============================================================================
+// Trig Backend Report
+// =============================================================================
+
+// Error of fix16_sincos() against double precision over [-2 pi, 2 pi] (in
+// 1/65536 units), and its cost per call for distinct angles, so the
+// libfixmath cache (default) and FIXMATH_SIN_QUARTER_WAVE can be compared
+static void report_trig(void) {
+    const fix16_t range = F16(6.28318530718);
+    double max_err = 0.0, sum_err = 0.0;
+    long samples = 0;
+    for (fix16_t a = -range; a <= range; a += 3) {
+        fix16_t s, c;
+        fix16_sincos(a, &s, &c);
+        double x = a / 65536.0;
+        double es = fabs(s - sin(x) * 65536.0), ec = fabs(c - cos(x) * 65536.0);
+        if (es > max_err) max_err = es;
+        if (ec > max_err) max_err = ec;
+        sum_err += es + ec;
+        samples += 2;
+    }
+
+    volatile fix16_t sink = 0;
+    long calls = 0;
+    uint64_t start = now_ns();
+    for (int pass = 0; pass < 8; pass++) {
+        for (fix16_t a = -range; a <= range; a += 7) {
+            fix16_t s, c;
+            fix16_sincos(a + pass, &s, &c);
+            sink += s + c;
+            calls++;
+        }
+    }
+    double ns = (double)(now_ns() - start) / calls;
+
+#ifdef FIXMATH_SIN_QUARTER_WAVE
+    const char *backend = "quarter-wave table";
+#else
+    const char *backend = "libfixmath cache";
+#endif
+    printf("trig      %s: max error %.2f, mean %.3f LSB, %.1f ns per fix16_sincos\n",
+           backend, max_err, sum_err / samples, ns);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char** argv) {
+    int frames = (argc > 1) ? atoi(argv[1]) : 3000;
+    uint32_t seed = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 1;
+    if (frames <= 0) frames = 1;
+
+    load_embedded_data();
+    rnd_state = seed;
+    game_init();
+    profiler_init();
+
+    // FNV-1a over every frame's screen
+    uint32_t checksum = 2166136261u;
+    uint64_t max_pixels = 0;
+    uint64_t start = now_ns();
+
+    for (int frame = 0; frame < frames; frame++) {
+        bench_buttons(frame);
+
+        PROF_BEGIN(PROF_UPDATE);
+        game_update();
+        PROF_END(PROF_UPDATE);
+
+        game_draw();
+
+        // Per pixel, so packed (SCREEN_4BPP) builds give the same checksum
+        for (int y = 0; y < SCREEN_HEIGHT; y++) {
+            for (int x = 0; x < SCREEN_WIDTH; x++) {
+                checksum = (checksum ^ screen_get(screen[y], x)) * 16777619u;
+            }
+        }
+
+        profiler_frame_end();
+        if (profiler_count(PROF_PIXELS) > max_pixels) max_pixels = profiler_count(PROF_PIXELS);
+    }
+
+    double total_ms = (double)(now_ns() - start) / 1e6;
+
+    printf("frames    %d (seed %u)\n", frames, (unsigned)seed);
+    printf("total     %.1f ms, %.1f us/frame\n", total_ms, total_ms * 1000.0 / frames);
+    printf("\n%-14s %10s %8s\n", "phase", "us/frame", "share");
+    uint64_t phase_sum = 0;
+    for (int i = 0; i < PROF_NUM_PHASES; i++) phase_sum += phase_ns[i];
+    for (int i = 0; i < PROF_NUM_PHASES; i++) {
+        if (phase_ns[i] == 0) continue;  // Device-only phases (present, vsync)
+        printf("%-14s %10.2f %7.1f%%\n", phase_names[i],
+               (double)phase_ns[i] / 1000.0 / frames,
+               phase_sum ? 100.0 * (double)phase_ns[i] / (double)phase_sum : 0.0);
+    }
+
+    double submitted = (double)total_counters[PROF_TRIS_SUBMITTED] / frames;
+    double rasterized = (double)total_counters[PROF_TRIS_RASTERIZED] / frames;
+    printf("\ntriangles %.1f submitted, %.1f rasterized, %.1f culled per frame\n",
+           submitted, rasterized, submitted - rasterized);
+    printf("pixels    %.1f per frame (max %llu)\n",
+           (double)total_counters[PROF_PIXELS] / frames, (unsigned long long)max_pixels);
+    if (total_counters[PROF_PIXELS_COVERED]) {
+        printf("covered   %.1f per frame skipped by the span buffer\n",
+               (double)total_counters[PROF_PIXELS_COVERED] / frames);
+    }
+    report_trig();
+    printf("checksum  %08x\n", (unsigned)checksum);
+
+    return 0;
+}
@@ -6,17 +6,41 @@
  * - SCREEN_WIDTH, SCREEN_HEIGHT
  * - FIX_SCREEN_CENTER, FIX_PROJ_CONST
  * - screen[][], spritesheet[][], map_memory[], palette_map[]
+ * - screen_get(), screen_put(), screen_fill() row accessors
  * - cls(), pset(), pget(), sget(), line(), rectfill(), circfill()
- * - spr(), pal(), pal_reset(), clip_set(), clip_reset(), color()
+ * - spr(), spr_cache_init(), pal(), pal_reset(), clip_set(), clip_reset(), color()
  * - btn(), btnp(), dget(), dset(), sfx()
  * - rnd_state, cart_data_dirty
  * - PSET_FAST(), SGET_FAST() macros
  * - libfixmath functions
+ *
+ * Optional hooks (default to no-ops):
+ * - SCREEN_MARK_SPAN(x0, x1, y): row y, columns x0..x1 written via PSET_FAST
+ * - PROF_BEGIN(phase), PROF_END(phase), PROF_COUNT(counter, n): profiler
+ *   hooks, see thumbycolor_profiler.h for the phase/counter names
  */
 
 #ifndef HYPERSPACE_GAME_H
 #define HYPERSPACE_GAME_H
 
+#include <assert.h>  // static_assert in C11
+
+#ifndef SCREEN_MARK_SPAN
+#define SCREEN_MARK_SPAN(x0, x1, y) ((void)0)
+#endif
+
+#ifndef PROF_BEGIN
+#define PROF_BEGIN(phase) ((void)0)
+#define PROF_END(phase) ((void)0)
+#define PROF_COUNT(counter, n) ((void)0)
+#endif
+
+// Unrecoverable setup error: report and halt (the device build maps this
+// to the SDK's panic())
+#ifndef GAME_FATAL
+#define GAME_FATAL(...) do { printf(__VA_ARGS__); printf("\n"); fflush(stdout); abort(); } while (0)
+#endif
+
 // PICO-8 compatible 3x5 font
 static const uint8_t font_data[96][5] = {
     {0x0,0x0,0x0,0x0,0x0}, // space
@@ -117,9 +141,31 @@ static const uint8_t font_data[96][5] = {
     {0x0,0x0,0x0,0x0,0x0}, // DEL
 };
 
+// Whole w x h cell at x, y inside the clip rectangle: glyph rows can be
+// written straight into screen
+static bool glyph_cell_visible(int x, int y, int w, int h) {
+    ClipRect r = clip_rect();
+    return x >= r.x1 && x + w - 1 <= r.x2 && y >= r.y1 && y + h - 1 <= r.y2;
+}
+
 static void print_char(char c, int x, int y, int col) {
     if (c < 32 || c > 127) return;
     int idx = c - 32;
+
+    if (glyph_cell_visible(x, y, 3, 5)) {
+        uint8_t p = palette_map[col & 15];
+        for (int row = 0; row < 5; row++) {
+            uint8_t bits = font_data[idx][row];
+            if (bits == 0) continue;
+            uint8_t* dst = screen[y + row];
+            if (bits & 4) screen_put(dst, x, p);
+            if (bits & 2) screen_put(dst, x + 1, p);
+            if (bits & 1) screen_put(dst, x + 2, p);
+            mark_dirty(x + __builtin_clz(bits) - 29, x + 2 - __builtin_ctz(bits), y + row);
+        }
+        return;
+    }
+
     for (int row = 0; row < 5; row++) {
         uint8_t bits = font_data[idx][row];
         for (int col_idx = 0; col_idx < 3; col_idx++) {
@@ -130,6 +176,28 @@ static void print_char(char c, int x, int y, int col) {
     }
 }
 
+// Glyph cache for print_3d(): each glyph drawn at (0, 0) in color 7 over
+// itself at (1, 1) in 13 and (2, 2) in 1, as 7 rows of a 5-pixel cell
+// (bit 4 = leftmost column). Each mask holds the pixels that layer shows.
+typedef struct {
+    uint8_t top, mid, shadow;
+} Glyph3DRow;
+
+static Glyph3DRow glyph_3d[96][7];
+
+static void init_glyphs(void) {
+    for (int g = 0; g < 96; g++) {
+        for (int row = 0; row < 7; row++) {
+            uint8_t top = row < 5 ? (uint8_t)(font_data[g][row] << 2) : 0;
+            uint8_t mid = row >= 1 && row < 6 ? (uint8_t)(font_data[g][row - 1] << 1) : 0;
+            uint8_t shadow = row >= 2 ? font_data[g][row - 2] : 0;
+            glyph_3d[g][row].top = top;
+            glyph_3d[g][row].mid = mid & ~top;
+            glyph_3d[g][row].shadow = shadow & ~(top | mid);
+        }
+    }
+}
+
 static void print_str(const char* str, int x, int y, int col) {
     int cx = x;
     while (*str) {
@@ -247,18 +315,26 @@ typedef struct {
     fix16_t m[12];  // 3x4 matrix
 } Mat34;
 
+// Fused, compile-time folded matrix chains (CXX_MATH build option); the C
+// helpers below stay for everything else
+#ifdef HYPERSPACE_CXX_MATH
+#ifndef __cplusplus
+#error "HYPERSPACE_CXX_MATH needs the game core compiled as C++17"
+#endif
+#include "hyperspace_math.hpp"
+#endif
+
 typedef struct {
     Vec3 pos;
     int tri[3];
     fix16_t uv[3][2];
     Vec3 normal;
-    fix16_t z;  // for sorting
 } Triangle;
 
 typedef struct {
-    Vec3* vertices;
+    const Vec3* vertices;
     Vec3* projected;
-    Triangle* triangles;
+    const Triangle* triangles;
     int num_vertices;
     int num_triangles;
 } Mesh;
@@ -268,25 +344,6 @@ typedef struct {
     int light_x;
 } Texture;
 
-typedef struct {
-    Vec3 pos0, pos1;
-    Vec3 proj0, proj1;
-    Vec3 spd;
-} Laser;
-
-typedef struct {
-    Vec3 pos0, pos1;
-    Vec3 proj0, proj1;
-    fix16_t spd;
-    int col;
-} Trail;
-
-typedef struct {
-    Vec3 pos;
-    fix16_t spd;
-    int index;
-    Vec3 proj;
-} Background;
 
 typedef struct {
     Vec3 pos;
@@ -294,6 +351,8 @@ typedef struct {
     Vec3* proj;
     int life;
     Vec3 light_dir;
+    bool visible;  // Passed the frustum test this frame (set by transform_vert)
+    const Mesh* draw_mesh;  // Mesh projected for drawing if visible, NULL for an impostor (HYPERSPACE_MESH_LOD)
     int hit_t;
     Vec3 hit_pos;
     fix16_t rot_x, rot_y;
@@ -320,39 +379,88 @@ static Mesh nme_meshes[4];
 static Texture nme_tex[4];
 static Texture nme_tex_hit;
 
-static fix16_t nme_scale[4] = {F16(1.0), F16(2.5), F16(3.0), F16(5.0)};
+// Also read by tools/bake_meshes.py, which applies it to the baked vertices
+#ifndef HYPERSPACE_BAKED_MESHES
+static const fix16_t nme_scale[4] = {F16(1.0), F16(2.5), F16(3.0), F16(5.0)};
+#endif
 static int nme_life[4] = {1, 3, 10, 80};
 static int nme_score[4] = {1, 10, 10, 100};
 static fix16_t nme_radius[4] = {F16(3.25), F16(6.0), F16(8.0), F16(16.0)};
+// Bounding sphere of each enemy mesh around its origin (set by init_nme).
+// nme_radius is the collision size and does not cover the meshes.
+static fix16_t nme_cull_radius[4];
+#ifdef HYPERSPACE_MESH_LOD
+// Enemy level of detail, picked per frame from the projected bounding
+// radius in pixels: the full mesh, the simplified mesh baked by
+// tools/bake_meshes.py (the full mesh again with BAKED_MESHES=OFF), or an
+// impostor dot in the main color of the enemy's texture
+#define NME_LOD_SIMPLE_PX   F16(6.0)
+#define NME_LOD_IMPOSTOR_PX F16(2.0)
+static Mesh nme_lod_meshes[4];
+static uint8_t nme_impostor_col[4];
+static uint8_t nme_impostor_col_hit;
+#endif
 static fix16_t nme_bounds[3] = {F16(-50.0), F16(-50.0), F16(-100.0)};
 static fix16_t nme_rot[3] = {F16(0.18), F16(0.24), F16(0.06)};
 static fix16_t nme_spd[3] = {F16(1.0), F16(0.5), F16(0.6)};
 
-// Trails
+// Object limits can be raised from the build (e.g. -DMAX_ENEMIES=40); the
+// render queue and projection pool are sized from them
+
+// Trails, backgrounds and lasers are stored as structure-of-arrays: one
+// column per coordinate, so projecting a whole system is one pass of
+// transform_points() over contiguous x/y/z columns.
+
+// Trails (line from pos0 to pos1, the previous pos0)
+#ifndef MAX_TRAILS
 #define MAX_TRAILS 32  // Reduced for PicoSystem memory
-static Trail trails[MAX_TRAILS];
+#endif
+typedef struct {
+    fix16_t x0[MAX_TRAILS], y0[MAX_TRAILS], z0[MAX_TRAILS];
+    fix16_t x1[MAX_TRAILS], y1[MAX_TRAILS], z1[MAX_TRAILS];
+    fix16_t spd[MAX_TRAILS];
+    int col[MAX_TRAILS];
+} TrailList;
+static TrailList trails;
 static int trail_color[5] = {7, 7, 6, 13, 1};
 
 // Backgrounds
+#ifndef MAX_BGS
 #define MAX_BGS 32  // Reduced for PicoSystem memory
-static Background bgs[MAX_BGS];
+#endif
+typedef struct {
+    fix16_t x[MAX_BGS], y[MAX_BGS], z[MAX_BGS];
+    fix16_t spd[MAX_BGS];
+    int index[MAX_BGS];
+} BackgroundList;
+static BackgroundList bgs;
 static int bg_color[3] = {12, 13, 6};
 
-// Lasers
+// Lasers (front end pos0, back end pos1 = last frame's pos0), each list
+// kept sorted by z0, ascending
+#ifndef MAX_LASERS
 #define MAX_LASERS 50  // Reduced for PicoSystem memory
-static Laser lasers[MAX_LASERS];
-static int num_lasers = 0;
-static Laser nme_lasers[MAX_LASERS];
-static int num_nme_lasers = 0;
-
-// Enemies
+#endif
+typedef struct {
+    fix16_t x0[MAX_LASERS], y0[MAX_LASERS], z0[MAX_LASERS];
+    fix16_t x1[MAX_LASERS], y1[MAX_LASERS], z1[MAX_LASERS];
+    fix16_t spd_x[MAX_LASERS], spd_y[MAX_LASERS], spd_z[MAX_LASERS];
+    int count;
+} LaserList;
+static LaserList lasers;
+static LaserList nme_lasers;
+
+// Enemies (sorted by pos.z, descending, at the end of update_nmes)
+#ifndef MAX_ENEMIES
 #define MAX_ENEMIES 25  // Reduced for PicoSystem memory
+#endif
 static Enemy enemies[MAX_ENEMIES];
 static int num_enemies = 0;
 static int nb_nme_ship = 0;
 
 // Camera
 static Mat34 cam_mat;
+static uint32_t cam_serial = 0;  // Bumped whenever cam_mat changes
 static fix16_t cam_x = 0, cam_y = 0;
 static fix16_t cam_angle_z = F16(-0.4);
 static fix16_t cam_angle_x = 0;
@@ -372,6 +480,9 @@ static fix16_t cur_noise_pitch = 0, old_noise_pitch = 0;
 // Light
 static Mat34 light_mat;
 static Vec3 light_dir, ship_light_dir;
+#ifdef HYPERSPACE_CXX_MATH
+static const fx::RotX light_tilt = fx::rotx(F16(0.14));  // Constant part of light_mat, built before main()
+#endif
 
 // Game state
 static int cur_mode = 0;
@@ -431,8 +542,10 @@ static int flare_offset = 0;
 // Explosion colors
 static int explosion_color[4] = {9, 10, 15, 7};
 
+#ifndef HYPERSPACE_BAKED_MESHES
 // mem_pos for decoding
 static int mem_pos = 0;
+#endif
 
 // ============================================================================
 // Fixed-Point Math Functions
@@ -480,8 +593,8 @@ static void vec3_normalize(Vec3* v) {
 
 static void mat_rotx(Mat34* m, fix16_t a) {
     fix16_t angle = fix16_mul(a, FIX_TWO_PI);
-    fix16_t cos_a = fix16_cos(angle);
-    fix16_t sin_a = fix16_sin(angle);
+    fix16_t sin_a, cos_a;
+    fix16_sincos(angle, &sin_a, &cos_a);
     // PICO-8's sin is negative of standard sin, so we negate sin_a
     m->m[0] = fix16_one; m->m[1] = 0; m->m[2] = 0; m->m[3] = 0;
     m->m[4] = 0; m->m[5] = cos_a; m->m[6] = -sin_a; m->m[7] = 0;
@@ -490,8 +603,8 @@ static void mat_rotx(Mat34* m, fix16_t a) {
 
 static void mat_roty(Mat34* m, fix16_t a) {
     fix16_t angle = fix16_mul(a, FIX_TWO_PI);
-    fix16_t cos_a = fix16_cos(angle);
-    fix16_t sin_a = fix16_sin(angle);
+    fix16_t sin_a, cos_a;
+    fix16_sincos(angle, &sin_a, &cos_a);
     // PICO-8's sin is negative of standard sin, so we negate sin_a
     m->m[0] = cos_a; m->m[1] = 0; m->m[2] = -sin_a; m->m[3] = 0;
     m->m[4] = 0; m->m[5] = fix16_one; m->m[6] = 0; m->m[7] = 0;
@@ -500,8 +613,8 @@ static void mat_roty(Mat34* m, fix16_t a) {
 
 static void mat_rotz(Mat34* m, fix16_t a) {
     fix16_t angle = fix16_mul(a, FIX_TWO_PI);
-    fix16_t cos_a = fix16_cos(angle);
-    fix16_t sin_a = fix16_sin(angle);
+    fix16_t sin_a, cos_a;
+    fix16_sincos(angle, &sin_a, &cos_a);
     // PICO-8's sin is negative of standard sin, so we negate sin_a
     m->m[0] = cos_a; m->m[1] = -sin_a; m->m[2] = 0; m->m[3] = 0;
     m->m[4] = sin_a; m->m[5] = cos_a; m->m[6] = 0; m->m[7] = 0;
@@ -580,6 +693,14 @@ static fix16_t smoothstep(fix16_t ratio) {
 // Mesh Decoding
 // ============================================================================
 
+#ifdef HYPERSPACE_BAKED_MESHES
+
+// Meshes generated at build time by tools/bake_meshes.py: scale and normal
+// division already applied, vertex/triangle tables const in flash.
+#include "hyperspace_meshes.h"
+
+#else
+
 // Read a raw byte from map memory and convert to signed value * 0.5
 static fix16_t decode_byte(void) {
     int res = map_memory[mem_pos];
@@ -602,27 +723,29 @@ static void decode_mesh(Mesh* mesh, fix16_t scale) {
     if (nb_vert < 0) nb_vert = 0;
     if (nb_vert > 256) nb_vert = 256;  // Sanity check
     mesh->num_vertices = nb_vert;
-    mesh->vertices = (Vec3*)calloc(nb_vert > 0 ? nb_vert : 1, sizeof(Vec3));
+    Vec3* vertices = (Vec3*)calloc(nb_vert > 0 ? nb_vert : 1, sizeof(Vec3));
+    mesh->vertices = vertices;
     mesh->projected = (Vec3*)calloc(nb_vert > 0 ? nb_vert : 1, sizeof(Vec3));
 
     printf("Decoding mesh: %d vertices at mem_pos=%d\n", nb_vert, mem_pos);
 
     for (int i = 0; i < nb_vert; i++) {
-        mesh->vertices[i].x = fix16_mul(decode_byte(), scale);
-        mesh->vertices[i].y = fix16_mul(decode_byte(), scale);
-        mesh->vertices[i].z = fix16_mul(decode_byte(), scale);
+        vertices[i].x = fix16_mul(decode_byte(), scale);
+        vertices[i].y = fix16_mul(decode_byte(), scale);
+        vertices[i].z = fix16_mul(decode_byte(), scale);
     }
 
     int nb_tri = decode_byte_int();
     if (nb_tri < 0) nb_tri = 0;
     if (nb_tri > 256) nb_tri = 256;  // Sanity check
     mesh->num_triangles = nb_tri;
-    mesh->triangles = (Triangle*)calloc(nb_tri > 0 ? nb_tri : 1, sizeof(Triangle));
+    Triangle* triangles = (Triangle*)calloc(nb_tri > 0 ? nb_tri : 1, sizeof(Triangle));
+    mesh->triangles = triangles;
 
     printf("Decoding mesh: %d triangles\n", nb_tri);
 
     for (int i = 0; i < nb_tri; i++) {
-        Triangle* tri = &mesh->triangles[i];
+        Triangle* tri = &triangles[i];
 
         // Vertex index (original is 1-based, convert to 0-based)
         tri->tri[0] = decode_byte_int() - 1;
@@ -642,16 +765,80 @@ static void decode_mesh(Mesh* mesh, fix16_t scale) {
     }
 }
 
+#endif // HYPERSPACE_BAKED_MESHES
+
+// ============================================================================
+// Enemy Projection Pool
+// ============================================================================
+
+// Every live enemy needs one projected vertex per mesh vertex. Buffers come
+// from a fixed pool (one slot per enemy) instead of the heap, so spawning
+// never allocates and a game restart cannot leak.
+#ifdef HYPERSPACE_BAKED_MESHES
+#define NME_MAX_VERTICES BAKED_NME_MAX_VERTICES
+#define NME_MAX_TRIANGLES BAKED_NME_MAX_TRIANGLES
+#else
+#ifndef NME_MAX_VERTICES
+#define NME_MAX_VERTICES 16  // Largest enemy mesh decoded at boot must fit
+#endif
+#ifndef NME_MAX_TRIANGLES
+#define NME_MAX_TRIANGLES 16
+#endif
+#endif
+
+static Vec3 nme_proj_pool[MAX_ENEMIES][NME_MAX_VERTICES];
+static uint8_t nme_proj_free[MAX_ENEMIES];  // Stack of free slot indices
+static int nme_proj_free_count = 0;
+static int nme_proj_high_water = 0;  // Most slots ever in use at once
+
+// Transform cache of each projection slot, so it stays with its enemy when
+// update_enemies() sorts or removes entries: what transform_vert() built last
+// time and the inputs it came from. Each part is rebuilt only when its
+// inputs changed.
+typedef struct {
+    bool valid;             // Cleared when the slot is acquired
+    fix16_t rot_x, rot_y;   // Angles of model's rotation
+    uint32_t cam_serial;    // cam_serial when view was built
+    Mat34 model;            // translate(pos) * rotx(rot_x) * rotz(rot_y)
+    Mat34 view;             // cam_mat * model
+} NmeTransform;
+
+static NmeTransform nme_xform_pool[MAX_ENEMIES];
+
+static void nme_proj_reset(void) {
+    for (int i = 0; i < MAX_ENEMIES; i++) {
+        nme_proj_free[i] = (uint8_t)(MAX_ENEMIES - 1 - i);
+    }
+    nme_proj_free_count = MAX_ENEMIES;
+}
+
+static Vec3* nme_proj_acquire(int num_vertices) {
+    if (num_vertices > NME_MAX_VERTICES || nme_proj_free_count == 0) return NULL;
+    int slot = nme_proj_free[--nme_proj_free_count];
+    int in_use = MAX_ENEMIES - nme_proj_free_count;
+    if (in_use > nme_proj_high_water) nme_proj_high_water = in_use;
+    nme_xform_pool[slot].valid = false;
+    return nme_proj_pool[slot];
+}
+
+static int nme_proj_slot(const Vec3* proj) {
+    return (int)((const Vec3 (*)[NME_MAX_VERTICES])proj - nme_proj_pool);
+}
+
+static void nme_proj_release(Vec3* proj) {
+    nme_proj_free[nme_proj_free_count++] = (uint8_t)nme_proj_slot(proj);
+}
+
 // ============================================================================
 // Projection
 // ============================================================================
 
-static void transform_pos(Vec3* proj, const Mat34* mat, const Vec3* pos) {
+static void HOT_FUNC(transform_pos)(Vec3* proj, const Mat34* mat, const Vec3* pos) {
     mat_mul_pos(proj, mat, pos);
 
     // c = -80 / z (for 128px screen) or -75 / z (for 120px screen)
     // When z is negative (in front of camera), c will be positive
-    fix16_t c = fix16_div(FIX_PROJ_CONST, proj->z);
+    fix16_t c = fix16_div_fast(FIX_PROJ_CONST, proj->z);
 
     proj->x = FIX_SCREEN_CENTER + fix16_mul(proj->x, c);
     proj->y = FIX_SCREEN_CENTER - fix16_mul(proj->y, c);
@@ -663,12 +850,271 @@ static void transform_pos(Vec3* proj, const Mat34* mat, const Vec3* pos) {
     }
 }
 
+// fix16_mul() as built here (FIXMATH_NO_OVERFLOW, rounding), inlined so
+// the batch kernel makes no call per multiply. Each product is rounded on
+// its own, as in mat_mul_pos(): accumulating the three products in 64 bits
+// before rounding (SMLAL) would not give the same pixels.
+static inline fix16_t fix16_mul_inline(fix16_t a, fix16_t b) {
+    int64_t product = (int64_t)a * b;
+    if (product < 0) product--;
+    return (fix16_t)(product >> 16) + (fix16_t)((product & 0x8000) >> 15);
+}
+
+// transform_pos() over n points in x/y/z columns, bit-identical to it. The
+// matrix is loaded once and stays in registers for the whole loop.
+static void HOT_FUNC(transform_points)(const Mat34* mat, const fix16_t* in_x, const fix16_t* in_y, const fix16_t* in_z,
+                             fix16_t* out_x, fix16_t* out_y, fix16_t* out_z, int n) {
+    const fix16_t m0 = mat->m[0], m1 = mat->m[1], m2 = mat->m[2], m3 = mat->m[3];
+    const fix16_t m4 = mat->m[4], m5 = mat->m[5], m6 = mat->m[6], m7 = mat->m[7];
+    const fix16_t m8 = mat->m[8], m9 = mat->m[9], m10 = mat->m[10], m11 = mat->m[11];
+
+    for (int i = 0; i < n; i++) {
+        fix16_t x = in_x[i], y = in_y[i], z = in_z[i];
+        fix16_t px = fix16_mul_inline(x, m0) + fix16_mul_inline(y, m1) + fix16_mul_inline(z, m2) + m3;
+        fix16_t py = fix16_mul_inline(x, m4) + fix16_mul_inline(y, m5) + fix16_mul_inline(z, m6) + m7;
+        fix16_t pz = fix16_mul_inline(x, m8) + fix16_mul_inline(y, m9) + fix16_mul_inline(z, m10) + m11;
+
+        fix16_t c = fix16_div_fast(FIX_PROJ_CONST, pz);
+        out_x[i] = FIX_SCREEN_CENTER + fix16_mul_inline(px, c);
+        out_y[i] = FIX_SCREEN_CENTER - fix16_mul_inline(py, c);
+        out_z[i] = (c > 0 && c <= F16(10.0)) ? c : 0;
+    }
+}
+
+// Scratch output of transform_points() for the largest system
+#define PROJ_BATCH_MAX_2(a, b) ((a) > (b) ? (a) : (b))
+#define PROJ_BATCH_MAX PROJ_BATCH_MAX_2(MAX_LASERS, PROJ_BATCH_MAX_2(MAX_TRAILS, MAX_BGS))
+
+typedef struct {
+    fix16_t x[PROJ_BATCH_MAX], y[PROJ_BATCH_MAX], z[PROJ_BATCH_MAX];
+} ProjBatch;
+static ProjBatch proj_batch[2];  // Both ends of a line
+
 // ============================================================================
 // Rasterization (Simplified for PicoSystem)
 // ============================================================================
 
-static void rasterize_flat_tri(Vec3* v0, Vec3* v1, Vec3* v2,
-                                fix16_t* uv0, fix16_t* uv1, fix16_t* uv2, fix16_t light) {
+// Span buffer (HYPERSPACE_SBUFFER)
+// rq_draw() walks the render queue front to back and one bit per pixel
+// records what this pass has already written, so every pixel is textured at
+// most once. The frontmost primitive in queue order still wins each pixel,
+// so the image is the same as painting back to front.
+// Without the option the run helpers return the whole range and the
+// coverage calls compile away.
+#ifdef HYPERSPACE_SBUFFER
+
+#define SBUF_WORDS (SCREEN_WIDTH / 32)
+
+static uint32_t sbuf_cover[SCREEN_HEIGHT][SBUF_WORDS];
+
+static void sbuf_reset(void) {
+    memset(sbuf_cover, 0, sizeof(sbuf_cover));
+}
+
+// First uncovered column of row py in x..x1 (x1 + 1 if there is none); the
+// run of uncovered pixels starting there ends at *last. The covered pixels
+// stepped over are counted as removed overdraw.
+static int sbuf_next_run(int py, int x, int x1, int* last) {
+    const uint32_t* row = sbuf_cover[py];
+    int start = x;
+
+    while (x <= x1) {
+        uint32_t open = ~row[x >> 5] >> (x & 31);
+        if (open) {
+            x += __builtin_ctz(open);
+            break;
+        }
+        x = (x | 31) + 1;
+    }
+    if (x > x1) {
+        if (x1 >= start) PROF_COUNT(PROF_PIXELS_COVERED, x1 + 1 - start);
+        return x1 + 1;
+    }
+    PROF_COUNT(PROF_PIXELS_COVERED, x - start);
+
+    int end = x + 1;
+    while (end <= x1) {
+        uint32_t covered = row[end >> 5] >> (end & 31);
+        if (covered) {
+            end += __builtin_ctz(covered);
+            break;
+        }
+        end = (end | 31) + 1;
+    }
+    *last = end - 1 < x1 ? end - 1 : x1;
+    return x;
+}
+
+static void sbuf_cover_run(int py, int x0, int x1) {
+    uint32_t* row = sbuf_cover[py];
+    for (int w = x0 >> 5; w <= x1 >> 5; w++) {
+        int lo = w == (x0 >> 5) ? (x0 & 31) : 0;
+        int hi = w == (x1 >> 5) ? (x1 & 31) : 31;
+        row[w] |= (0xFFFFFFFFu >> (31 - hi)) & (0xFFFFFFFFu << lo);
+    }
+}
+
+#else
+
+static inline void sbuf_reset(void) {}
+
+static inline int sbuf_next_run(int py, int x, int x1, int* last) {
+    (void)py;
+    *last = x1;
+    return x;
+}
+
+static inline void sbuf_cover_run(int py, int x0, int x1) {
+    (void)py; (void)x0; (void)x1;
+}
+
+#endif
+
+// Record run x0..x1 of row py as written (dirty span and coverage)
+static inline void sbuf_write_run(int py, int x0, int x1) {
+    SCREEN_MARK_SPAN(x0, x1, py);
+    sbuf_cover_run(py, x0, x1);
+}
+
+// Iterate the uncovered runs [run, last] of row py within x0..x1
+#define SBUF_FOR_RUNS(py, x0, x1, run, last) \
+    for (int run = sbuf_next_run((py), (x0), (x1), &last); run <= (x1); \
+         run = sbuf_next_run((py), last + 1, (x1), &last))
+
+// Texture mapper
+// By default perspective-correct UVs are computed exactly at the ends of
+// TEXMAP_SPAN-pixel spans and stepped linearly (integer adds) in between,
+// so each span costs one divide instead of one per pixel. Define
+// HYPERSPACE_EXACT_TEXMAP to divide at every pixel instead.
+#ifndef TEXMAP_SPAN_SHIFT
+#define TEXMAP_SPAN_SHIFT 4
+#endif
+#define TEXMAP_SPAN (1 << TEXMAP_SPAN_SHIFT)
+
+// Per-vertex perspective weights (proj z) and UVs of a flat triangle, plus
+// the whole-texel UV extent of those UVs
+typedef struct {
+    fix16_t z0, z1, z2;
+    fix16_t u0, v0, u1, v1, u2, v2;
+    int u_min, u_max, v_min, v_max;
+} TexmapVerts;
+
+// Texel fetch clamped to the triangle's own UV extent. Near a degenerate
+// weight the perspective divide can return UVs far outside the triangle;
+// clamping keeps those fetches on the triangle's texture (never a
+// neighbouring sprite) and leaves every in-range fetch unchanged
+static inline uint8_t texmap_texel(const TexmapVerts* tv, int u, int v, int offset_x, int tex_y) {
+    if (u < tv->u_min) u = tv->u_min;
+    if (u > tv->u_max) u = tv->u_max;
+    if (v < tv->v_min) v = tv->v_min;
+    if (v > tv->v_max) v = tv->v_max;
+    return SGET_FAST(u + offset_x, v + tex_y);
+}
+
+// Perspective-correct UV from screen-space barycentrics b0, b1
+// Returns false where the perspective weight degenerates (pixel is skipped)
+static inline bool texmap_uv(fix16_t b0, fix16_t b1, const TexmapVerts* tv,
+                             fix16_t* u, fix16_t* v) {
+    fix16_t b2 = fix16_one - b0 - b1;
+
+    b0 = fix16_mul(b0, tv->z0);
+    b1 = fix16_mul(b1, tv->z1);
+    b2 = fix16_mul(b2, tv->z2);
+
+    fix16_t d2 = b0 + b1 + b2;
+    if (fix16_abs(d2) < F16(0.001)) return false;
+
+    fix16_t inv_d2 = fix16_recip(d2);
+    *u = fix16_mul(fix16_mul(b0, tv->u0) + fix16_mul(b1, tv->u1) + fix16_mul(b2, tv->u2), inv_d2);
+    *v = fix16_mul(fix16_mul(b0, tv->v0) + fix16_mul(b1, tv->v1) + fix16_mul(b2, tv->v2), inv_d2);
+    return true;
+}
+
+#ifndef HYPERSPACE_EXACT_TEXMAP
+
+// Texture one scanline of count pixels starting at px
+// lit_mask bit (px & 7) selects the lit texture half (row dither pattern)
+static void HOT_FUNC(texmap_scanline)(int px, int py, int count, fix16_t b0, fix16_t b1,
+                            fix16_t db0_dx, fix16_t db1_dx, const TexmapVerts* tv,
+                            int tex_x, int tex_y, int tex_lit_x, int lit_mask) {
+    fix16_t u0 = 0, v0 = 0;
+    bool ok0 = false;
+    bool have0 = false;  // u0/v0 already sampled at px
+
+    while (count > 0) {
+        int len = count < TEXMAP_SPAN ? count : TEXMAP_SPAN;
+        // Distance to the next exact sample: the next span's first pixel,
+        // or this span's last pixel on the final span
+        int steps = (len == count) ? len - 1 : len;
+        int span_last = px + len - 1;
+
+        fix16_t b0_end = b0 + steps * db0_dx;
+        fix16_t b1_end = b1 + steps * db1_dx;
+
+        // Spans already fully covered by the span buffer take no samples
+        int last;
+        int first = sbuf_next_run(py, px, span_last, &last);
+        if (first <= span_last) {
+            if (!have0) ok0 = texmap_uv(b0, b1, tv, &u0, &v0);
+            fix16_t u1 = 0, v1 = 0;
+            bool ok1 = texmap_uv(b0_end, b1_end, tv, &u1, &v1);
+
+            if (ok0 && ok1) {
+                fix16_t du = 0, dv = 0;
+                if (steps == TEXMAP_SPAN) {
+                    du = (u1 - u0) >> TEXMAP_SPAN_SHIFT;
+                    dv = (v1 - v0) >> TEXMAP_SPAN_SHIFT;
+                } else if (steps > 0) {
+                    du = (u1 - u0) / steps;
+                    dv = (v1 - v0) / steps;
+                }
+
+                for (int run = first; run <= span_last; run = sbuf_next_run(py, last + 1, span_last, &last)) {
+                    sbuf_write_run(py, run, last);
+                    fix16_t u = u0 + (run - px) * du;
+                    fix16_t v = v0 + (run - px) * dv;
+                    for (int x = run; x <= last; x++) {
+                        int offset_x = tex_x + (tex_lit_x & -((lit_mask >> (x & 7)) & 1));
+                        PSET_FAST(x, py, texmap_texel(tv, u >> 16, v >> 16, offset_x, tex_y));
+                        u += du;
+                        v += dv;
+                    }
+                }
+            } else {
+                // Span crosses a degenerate weight: exact per pixel, like the
+                // exact mapper. Skipped pixels stay uncovered.
+                for (int run = first; run <= span_last; run = sbuf_next_run(py, last + 1, span_last, &last)) {
+                    SCREEN_MARK_SPAN(run, last, py);
+                    for (int x = run; x <= last; x++) {
+                        fix16_t u, v;
+                        int i = x - px;
+                        if (!texmap_uv(b0 + i * db0_dx, b1 + i * db1_dx, tv, &u, &v)) continue;
+                        int offset_x = tex_x + (tex_lit_x & -((lit_mask >> (x & 7)) & 1));
+                        PSET_FAST(x, py, texmap_texel(tv, fix16_to_int(u), fix16_to_int(v), offset_x, tex_y));
+                        sbuf_cover_run(py, x, x);
+                    }
+                }
+            }
+
+            u0 = u1;
+            v0 = v1;
+            ok0 = ok1;
+            have0 = true;
+        } else {
+            have0 = false;
+        }
+
+        b0 = b0_end;
+        b1 = b1_end;
+        px += len;
+        count -= len;
+    }
+}
+
+#endif
+
+static void HOT_FUNC(rasterize_flat_tri)(Vec3* v0, Vec3* v1, Vec3* v2,
+                                const fix16_t* uv0, const fix16_t* uv1, const fix16_t* uv2, fix16_t light) {
     fix16_t y0 = v0->y;
     fix16_t y1 = v1->y;
 
@@ -687,13 +1133,22 @@ static void rasterize_flat_tri(Vec3* v0, Vec3* v1, Vec3* v2,
     if (firstline < FIX_HALF) firstline = FIX_HALF;
     if (lastline > F16(SCREEN_HEIGHT - 0.5)) lastline = F16(SCREEN_HEIGHT - 0.5);
 
-    fix16_t x0 = v0->x, z0 = v0->z;
-    fix16_t x1 = v1->x, z1 = v1->z;
-    fix16_t x2 = v2->x, y2 = v2->y, z2 = v2->z;
+    fix16_t x0 = v0->x;
+    fix16_t x1 = v1->x;
+    fix16_t x2 = v2->x, y2 = v2->y;
 
-    fix16_t uv0x = uv0[0], uv0y = uv0[1];
-    fix16_t uv1x = uv1[0], uv1y = uv1[1];
-    fix16_t uv2x = uv2[0], uv2y = uv2[1];
+    // Floor of the smallest and rounded largest UV: both the span mapper
+    // (u >> 16) and the exact one (fix16_to_int) stay inside on real UVs
+    fix16_t u_lo = uv0[0] < uv1[0] ? (uv0[0] < uv2[0] ? uv0[0] : uv2[0]) : (uv1[0] < uv2[0] ? uv1[0] : uv2[0]);
+    fix16_t u_hi = uv0[0] > uv1[0] ? (uv0[0] > uv2[0] ? uv0[0] : uv2[0]) : (uv1[0] > uv2[0] ? uv1[0] : uv2[0]);
+    fix16_t v_lo = uv0[1] < uv1[1] ? (uv0[1] < uv2[1] ? uv0[1] : uv2[1]) : (uv1[1] < uv2[1] ? uv1[1] : uv2[1]);
+    fix16_t v_hi = uv0[1] > uv1[1] ? (uv0[1] > uv2[1] ? uv0[1] : uv2[1]) : (uv1[1] > uv2[1] ? uv1[1] : uv2[1]);
+
+    TexmapVerts tv = {
+        v0->z, v1->z, v2->z,
+        uv0[0], uv0[1], uv1[0], uv1[1], uv2[0], uv2[1],
+        u_lo >> 16, fix16_to_int(u_hi), v_lo >> 16, fix16_to_int(v_hi)
+    };
 
     fix16_t cb0 = fix16_mul(x1, y2) - fix16_mul(x2, y1);
     fix16_t cb1 = fix16_mul(x2, y0) - fix16_mul(x0, y2);
@@ -703,7 +1158,12 @@ static void rasterize_flat_tri(Vec3* v0, Vec3* v1, Vec3* v2,
 
     fix16_t dy = y1 - y0;
     if (fix16_abs(dy) < F16(0.001)) return;
-    fix16_t invdy = fix16_div(fix16_one, dy);
+    fix16_t invdy = fix16_recip(dy);
+
+    // Scanline gradients (d is constant over the triangle)
+    fix16_t inv_d = fix16_recip(d);
+    fix16_t db0_dx = fix16_mul(y1 - y2, inv_d);
+    fix16_t db1_dx = fix16_mul(y2 - y0, inv_d);
 
     int tex_x = cur_tex->x;
     int tex_y = cur_tex->y;
@@ -721,50 +1181,54 @@ static void rasterize_flat_tri(Vec3* v0, Vec3* v1, Vec3* v2,
         fix16_t x1y = fix16_mul(x1, y);
         fix16_t x2y = fix16_mul(x2, y);
 
-        // Pre-compute scanline gradients (avoid division in inner loop)
-        fix16_t inv_d = fix16_div(fix16_one, d);
-        fix16_t db0_dx = fix16_mul(y1 - y2, inv_d);
-        fix16_t db1_dx = fix16_mul(y2 - y0, inv_d);
-
         fix16_t b0_base = fix16_mul(cb0 + fix16_mul(xfirst, y1) + x2y - fix16_mul(xfirst, y2) - x1y, inv_d);
         fix16_t b1_base = fix16_mul(cb1 + fix16_mul(xfirst, y2) + x0y - fix16_mul(xfirst, y0) - x2y, inv_d);
 
         int py = fix16_to_int(y);
         int dither_row = 56 + (py & 7);  // bitmask instead of modulo
 
-        for (fix16_t x = xfirst; x <= xlast; x += fix16_one) {
-            fix16_t b0 = b0_base;
-            fix16_t b1 = b1_base;
-            fix16_t b2 = fix16_one - b0 - b1;
-
-            b0_base += db0_dx;
-            b1_base += db1_dx;
-
-            b0 = fix16_mul(b0, z0);
-            b1 = fix16_mul(b1, z1);
-            b2 = fix16_mul(b2, z2);
-
-            fix16_t d2 = b0 + b1 + b2;
-            if (fix16_abs(d2) < F16(0.001)) continue;
-
-            fix16_t inv_d2 = fix16_div(fix16_one, d2);
-            fix16_t uvx = fix16_mul(fix16_mul(b0, uv0x) + fix16_mul(b1, uv1x) + fix16_mul(b2, uv2x), inv_d2);
-            fix16_t uvy = fix16_mul(fix16_mul(b0, uv0y) + fix16_mul(b1, uv1y) + fix16_mul(b2, uv2y), inv_d2);
+        if (xfirst > xlast) continue;
+
+#ifdef HYPERSPACE_EXACT_TEXMAP
+        int px_first = fix16_to_int(xfirst);
+        int last;
+        SBUF_FOR_RUNS(py, px_first, fix16_to_int(xlast), run, last) {
+            SCREEN_MARK_SPAN(run, last, py);
+            for (int px = run; px <= last; px++) {
+                fix16_t uvx, uvy;
+                int i = px - px_first;
+                if (!texmap_uv(b0_base + i * db0_dx, b1_base + i * db1_dx, &tv, &uvx, &uvy)) continue;
+
+                int offset_x = tex_x;
+                int dither_val = SGET_FAST(px & 7, dither_row);  // bitmask instead of modulo
+                if (light <= F16(7.0) + fix16_mul(fix16_from_int(dither_val), F16(0.125))) {
+                    offset_x += tex_lit_x;
+                }
 
-            int px = fix16_to_int(x);
-            int offset_x = tex_x;
-            int dither_val = SGET_FAST(px & 7, dither_row);  // bitmask instead of modulo
-            if (light <= F16(7.0) + fix16_mul(fix16_from_int(dither_val), F16(0.125))) {
-                offset_x += tex_lit_x;
+                PSET_FAST(px, py, texmap_texel(&tv, fix16_to_int(uvx), fix16_to_int(uvy), offset_x, tex_y));
+                sbuf_cover_run(py, px, px);
             }
+        }
+#else
 
-            PSET_FAST(px, py, SGET_FAST(fix16_to_int(uvx) + offset_x, fix16_to_int(uvy) + tex_y));
+        // The dithered light test only depends on px & 7 along this row
+        int lit_mask = 0;
+        for (int i = 0; i < 8; i++) {
+            if (light <= F16(7.0) + fix16_mul(fix16_from_int(SGET_FAST(i, dither_row)), F16(0.125))) {
+                lit_mask |= 1 << i;
+            }
         }
+
+        texmap_scanline(fix16_to_int(xfirst), py, fix16_to_int(xlast - xfirst) + 1,
+                        b0_base, b1_base, db0_dx, db1_dx, &tv,
+                        tex_x, tex_y, tex_lit_x, lit_mask);
+#endif
     }
 }
 
-static void rasterize_tri(int index, Triangle* tris, Vec3* projs) {
-    Triangle* tri = &tris[index];
+static void HOT_FUNC(rasterize_tri)(int index, const Triangle* tris, Vec3* projs) {
+    const Triangle* tri = &tris[index];
+    PROF_COUNT(PROF_TRIS_SUBMITTED, 1);
 
     if (tri->tri[0] < 0 || tri->tri[1] < 0 || tri->tri[2] < 0) return;
     if (cur_tex == NULL) return;
@@ -793,33 +1257,34 @@ static void rasterize_tri(int index, Triangle* tris, Vec3* projs) {
     fix16_t nz = fix16_mul(x1 - x0, y2 - y0) - fix16_mul(y1 - y0, x2 - x0);
     if (nz < 0) return;
 
-    fix16_t* uv0 = tri->uv[0];
-    fix16_t* uv1 = tri->uv[1];
-    fix16_t* uv2 = tri->uv[2];
+    const fix16_t* uv0 = tri->uv[0];
+    const fix16_t* uv1 = tri->uv[1];
+    const fix16_t* uv2 = tri->uv[2];
 
     // Sort by Y
     Vec3 *tv0 = v0, *tv1 = v1, *tv2 = v2;
-    fix16_t *tuv0 = uv0, *tuv1 = uv1, *tuv2 = uv2;
+    const fix16_t *tuv0 = uv0, *tuv1 = uv1, *tuv2 = uv2;
 
-    if (tv1->y < tv0->y) { Vec3* t = tv1; tv1 = tv0; tv0 = t; fix16_t* tu = tuv1; tuv1 = tuv0; tuv0 = tu; }
-    if (tv2->y < tv0->y) { Vec3* t = tv2; tv2 = tv0; tv0 = t; fix16_t* tu = tuv2; tuv2 = tuv0; tuv0 = tu; }
-    if (tv2->y < tv1->y) { Vec3* t = tv2; tv2 = tv1; tv1 = t; fix16_t* tu = tuv2; tuv2 = tuv1; tuv1 = tu; }
+    if (tv1->y < tv0->y) { Vec3* t = tv1; tv1 = tv0; tv0 = t; const fix16_t* tu = tuv1; tuv1 = tuv0; tuv0 = tu; }
+    if (tv2->y < tv0->y) { Vec3* t = tv2; tv2 = tv0; tv0 = t; const fix16_t* tu = tuv2; tuv2 = tuv0; tuv0 = tu; }
+    if (tv2->y < tv1->y) { Vec3* t = tv2; tv2 = tv1; tv1 = t; const fix16_t* tu = tuv2; tuv2 = tuv1; tuv1 = tu; }
 
     y0 = tv0->y; y1 = tv1->y; y2 = tv2->y;
     x0 = tv0->x;
     fix16_t z0 = tv0->z, z2 = tv2->z;
 
     if (y0 == y2) return;
+    PROF_COUNT(PROF_TRIS_RASTERIZED, 1);
 
     fix16_t light = fix16_mul(F16(15.0), vec3_dot(t_light_dir, &tri->normal));
 
-    fix16_t c = fix16_div(y1 - y0, y2 - y0);
+    fix16_t c = fix16_div_fast(y1 - y0, y2 - y0);
     Vec3 v3 = {x0 + fix16_mul(c, tv2->x - x0), y1, z0 + fix16_mul(c, z2 - z0)};
 
     fix16_t b0 = fix16_mul(fix16_one - c, z0);
     fix16_t b1 = fix16_mul(c, z2);
     fix16_t sum = b0 + b1;
-    fix16_t invd = (sum > F16(0.001)) ? fix16_div(fix16_one, sum) : 0;
+    fix16_t invd = (sum > F16(0.001)) ? fix16_recip(sum) : 0;
 
     fix16_t uv3[2] = {
         fix16_mul(fix16_mul(b0, tuv0[0]) + fix16_mul(b1, tuv2[0]), invd),
@@ -835,22 +1300,185 @@ static void rasterize_tri(int index, Triangle* tris, Vec3* projs) {
     }
 }
 
-// Insertion sort - faster than qsort for small arrays (typical mesh has <20 tris)
-static void sort_tris(Triangle* tris, int num, Vec3* projs) {
-    // First pass: compute z for each triangle
-    for (int i = 0; i < num; i++) {
-        Triangle* tri = &tris[i];
-        tri->z = projs[tri->tri[0]].z + projs[tri->tri[1]].z + projs[tri->tri[2]].z;
+// ============================================================================
+// Render Queue
+// ============================================================================
+
+// Depth-sorted drawing across meshes. Each queued triangle or explosion is
+// one 32-bit entry:
+//   depth key (bits 16-31) | owner (bits 8-15) | index (bits 0-7)
+// where owner is an enemy index, RQ_OWNER_SHIP or RQ_OWNER_EXPLOSION. The
+// frame's enemy triangles and explosions go into one queue, sorted back to
+// front by key, so overlapping enemies draw correctly whatever their order
+// in enemies[]. The sort moves 4-byte entries instead of Triangle structs
+// and is stable: equal depths keep submission order.
+// Worst case: every enemy queues all its triangles and up to 3 explosions
+#define RQ_MAX_CIRCLES    (MAX_ENEMIES * 3)
+#define RENDER_QUEUE_SIZE (MAX_ENEMIES * NME_MAX_TRIANGLES + RQ_MAX_CIRCLES)
+#define RQ_INSERTION_MAX  32   // Below this, insertion sort beats two radix passes
+
+#define RQ_OWNER_SHIP      0xFE
+#define RQ_OWNER_EXPLOSION 0xFF
+
+static_assert(MAX_ENEMIES < RQ_OWNER_SHIP, "enemy index must fit the render queue owner byte");
+static_assert(RQ_MAX_CIRCLES <= 256 && NME_MAX_TRIANGLES <= 256, "render queue index must fit a byte");
+
+// Explosion circle, resolved when queued
+typedef struct {
+    int16_t x, y, r;
+    uint8_t col;
+} RenderCircle;
+
+static uint32_t rq_entries[RENDER_QUEUE_SIZE];
+static uint32_t rq_scratch[RENDER_QUEUE_SIZE];
+static uint16_t rq_histogram[256];
+static int rq_count;
+
+static RenderCircle rq_circles[RQ_MAX_CIRCLES];
+static int rq_num_circles;
+
+// Enemy texture for this frame (hit flash), indexed by owner
+static Texture* rq_nme_tex[MAX_ENEMIES];
+
+static void rq_reset(void) {
+    rq_count = 0;
+    rq_num_circles = 0;
+}
+
+// z_sum: sum of the projected z (1/depth, at most 10.0) of three vertices
+static void rq_push(fix16_t z_sum, int owner, int index) {
+    if (rq_count >= RENDER_QUEUE_SIZE) return;
+    uint32_t key = z_sum > 0 ? (uint32_t)z_sum >> 5 : 0;
+    if (key > 0xFFFF) key = 0xFFFF;
+    rq_entries[rq_count++] = (key << 16) | ((uint32_t)owner << 8) | (uint32_t)index;
+}
+
+static void rq_push_mesh(const Mesh* mesh, const Vec3* projs, int owner) {
+    for (int i = 0; i < mesh->num_triangles; i++) {
+        const Triangle* tri = &mesh->triangles[i];
+        fix16_t z_sum = 0;
+        // Invalid indices are rejected by rasterize_tri()
+        if (tri->tri[0] >= 0 && tri->tri[1] >= 0 && tri->tri[2] >= 0) {
+            z_sum = projs[tri->tri[0]].z + projs[tri->tri[1]].z + projs[tri->tri[2]].z;
+        }
+        rq_push(z_sum, owner, i);
+    }
+}
+
+static void explosion_circle(const Vec3* proj, fix16_t size, RenderCircle* c);
+
+// Random draws happen now, in submission order, so the RNG sequence does not
+// depend on the sorted draw order
+static void rq_push_explosion(const Vec3* proj, fix16_t size) {
+    RenderCircle c;
+    explosion_circle(proj, size, &c);
+    if (rq_num_circles >= RQ_MAX_CIRCLES) return;
+    rq_circles[rq_num_circles] = c;
+    rq_push(proj->z * 3, RQ_OWNER_EXPLOSION, rq_num_circles++);
+}
+
+#ifdef HYPERSPACE_MESH_LOD
+// Impostors are queued as circles, like explosions: one pixel, or a
+// 5-pixel cross from a 1.5-pixel projected radius
+static void rq_push_impostor(const Enemy* nme, const Texture* tex) {
+    Vec3 p;
+    transform_pos(&p, &cam_mat, &nme->pos);
+    if (rq_num_circles >= RQ_MAX_CIRCLES) return;
+    RenderCircle* c = &rq_circles[rq_num_circles];
+    c->x = fix16_to_int(p.x);
+    c->y = fix16_to_int(p.y);
+    c->r = fix16_mul(nme_cull_radius[nme->type - 1], p.z) >= F16(1.5) ? 1 : 0;
+    c->col = tex == &nme_tex_hit ? nme_impostor_col_hit : nme_impostor_col[nme->type - 1];
+    rq_push(p.z * 3, RQ_OWNER_EXPLOSION, rq_num_circles++);
+}
+#endif
+
+// Ascending key = back to front
+static void rq_sort(void) {
+    if (rq_count <= RQ_INSERTION_MAX) {
+        for (int i = 1; i < rq_count; i++) {
+            uint32_t e = rq_entries[i];
+            int j = i - 1;
+            while (j >= 0 && (rq_entries[j] >> 16) > (e >> 16)) {
+                rq_entries[j + 1] = rq_entries[j];
+                j--;
+            }
+            rq_entries[j + 1] = e;
+        }
+        return;
     }
-    // Insertion sort by z (ascending = back to front)
-    for (int i = 1; i < num; i++) {
-        Triangle temp = tris[i];
-        int j = i - 1;
-        while (j >= 0 && tris[j].z > temp.z) {
-            tris[j + 1] = tris[j];
-            j--;
+
+    // LSD radix sort on the key, low byte then high byte (ends in rq_entries)
+    uint32_t* src = rq_entries;
+    uint32_t* dst = rq_scratch;
+    for (int shift = 16; shift < 32; shift += 8) {
+        memset(rq_histogram, 0, sizeof(rq_histogram));
+        for (int i = 0; i < rq_count; i++) rq_histogram[(src[i] >> shift) & 0xFF]++;
+        uint16_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            uint16_t n = rq_histogram[b];
+            rq_histogram[b] = offset;
+            offset += n;
+        }
+        for (int i = 0; i < rq_count; i++) dst[rq_histogram[(src[i] >> shift) & 0xFF]++] = src[i];
+        uint32_t* t = src; src = dst; dst = t;
+    }
+}
+
+// Ship entries use the current cur_tex / t_light_dir
+// circfill() through the span buffer (same pixels, clip region honoured)
+static void rq_draw_circle(const RenderCircle* c) {
+#ifdef HYPERSPACE_SBUFFER
+    uint8_t col = palette_map[c->col & 15];
+    int r = c->r;
+    int w = 0;  // Half width of the current row
+    for (int y = -r; y <= r; y++) {
+        int py = c->y + y;
+        int rem = r * r - y * y;
+        while ((w + 1) * (w + 1) <= rem) w++;
+        while (w * w > rem) w--;
+
+        if (py < clip_y1 || py > clip_y2 || py < 0 || py >= SCREEN_HEIGHT) continue;
+        int x0 = c->x - w, x1 = c->x + w;
+        if (x0 < clip_x1) x0 = clip_x1;
+        if (x0 < 0) x0 = 0;
+        if (x1 > clip_x2) x1 = clip_x2;
+        if (x1 > SCREEN_WIDTH - 1) x1 = SCREEN_WIDTH - 1;
+        if (x0 > x1) continue;
+
+        int last;
+        SBUF_FOR_RUNS(py, x0, x1, run, last) {
+            sbuf_write_run(py, run, last);
+            screen_fill(screen[py], run, last, col);
+        }
+    }
+#else
+    circfill(c->x, c->y, c->r, c->col);
+#endif
+}
+
+static void HOT_FUNC(rq_draw)(void) {
+#ifdef HYPERSPACE_SBUFFER
+    // Front to back: the span buffer keeps the first (nearest) write
+    sbuf_reset();
+    for (int i = rq_count - 1; i >= 0; i--) {
+#else
+    for (int i = 0; i < rq_count; i++) {
+#endif
+        uint32_t e = rq_entries[i];
+        int owner = (e >> 8) & 0xFF;
+        int index = e & 0xFF;
+
+        if (owner == RQ_OWNER_EXPLOSION) {
+            rq_draw_circle(&rq_circles[index]);
+        } else if (owner == RQ_OWNER_SHIP) {
+            rasterize_tri(index, ship_mesh.triangles, ship_mesh.projected);
+        } else {
+            Enemy* nme = &enemies[owner];
+            cur_tex = rq_nme_tex[owner];
+            t_light_dir = &nme->light_dir;
+            rasterize_tri(index, nme->draw_mesh->triangles, nme->proj);
         }
-        tris[j + 1] = temp;
     }
 }
 
@@ -859,8 +1487,12 @@ static void sort_tris(Triangle* tris, int num, Vec3* projs) {
 // ============================================================================
 
 static void init_ship(void) {
+#ifdef HYPERSPACE_BAKED_MESHES
+    ship_mesh = baked_meshes[0];
+#else
     mem_pos = 0;
     decode_mesh(&ship_mesh, fix16_one);
+#endif
 
     ship_tex.x = 0;
     ship_tex.y = 96;
@@ -871,48 +1503,118 @@ static void init_ship(void) {
     ship_tex_laser_lit.light_x = 48;
 }
 
+#ifdef HYPERSPACE_MESH_LOD
+// Most used color other than black in a texture's unshaded 16x16 half
+static uint8_t texture_main_col(const Texture* tex) {
+    int count[16] = {0};
+    for (int y = 0; y < 16; y++) {
+        for (int x = 0; x < 16; x++) count[SGET_FAST(tex->x + x, tex->y + y) & 15]++;
+    }
+    int best = 1;
+    for (int col = 2; col < 16; col++) {
+        if (count[col] > count[best]) best = col;
+    }
+    return (uint8_t)best;
+}
+
+// Mesh to draw at this frame's size, NULL for an impostor. mat_z is the
+// camera-space depth of the enemy origin. Dying enemies keep the full mesh:
+// their explosions are spread over all its vertices.
+static const Mesh* nme_lod_mesh(const Enemy* nme, fix16_t mat_z) {
+    const Mesh* mesh = &nme_meshes[nme->type - 1];
+    if (nme->life <= 0 || mat_z >= 0) return mesh;
+    fix16_t radius = fix16_mul(nme_cull_radius[nme->type - 1], fix16_div_fast(FIX_PROJ_CONST, mat_z));
+    if (radius < NME_LOD_IMPOSTOR_PX) return NULL;
+    if (radius < NME_LOD_SIMPLE_PX) return &nme_lod_meshes[nme->type - 1];
+    return mesh;
+}
+#endif
+
 static void init_nme(void) {
     for (int i = 0; i < 4; i++) {
+#ifdef HYPERSPACE_BAKED_MESHES
+        nme_meshes[i] = baked_meshes[i + 1];
+#else
         decode_mesh(&nme_meshes[i], nme_scale[i]);
+        // nme_proj_acquire() would refuse the mesh and that enemy type
+        // would silently never spawn
+        if (nme_meshes[i].num_vertices > NME_MAX_VERTICES) {
+            GAME_FATAL("Enemy mesh %d has %d vertices, NME_MAX_VERTICES is %d",
+                       i, nme_meshes[i].num_vertices, NME_MAX_VERTICES);
+        }
+        if (nme_meshes[i].num_triangles > NME_MAX_TRIANGLES) {
+            GAME_FATAL("Enemy mesh %d has %d triangles, NME_MAX_TRIANGLES is %d",
+                       i, nme_meshes[i].num_triangles, NME_MAX_TRIANGLES);
+        }
+#endif
         nme_tex[i].x = i * 32;
         nme_tex[i].y = 32;
         nme_tex[i].light_x = 16;
+
+        fix16_t max_sqr = 0;
+        for (int j = 0; j < nme_meshes[i].num_vertices; j++) {
+            const Vec3* v = &nme_meshes[i].vertices[j];
+            fix16_t sqr = fix16_mul(v->x, v->x) + fix16_mul(v->y, v->y) + fix16_mul(v->z, v->z);
+            if (sqr > max_sqr) max_sqr = sqr;
+        }
+        // Margin covers rotation and projection rounding
+        nme_cull_radius[i] = fix16_sqrt(max_sqr) + FIX_HALF;
     }
 
     nme_tex_hit.x = 96;
     nme_tex_hit.y = 64;
     nme_tex_hit.light_x = 16;
+
+#ifdef HYPERSPACE_MESH_LOD
+    for (int i = 0; i < 4; i++) {
+#ifdef HYPERSPACE_BAKED_MESHES
+        nme_lod_meshes[i] = baked_nme_lod_meshes[i];
+#else
+        nme_lod_meshes[i] = nme_meshes[i];
+#endif
+        nme_impostor_col[i] = texture_main_col(&nme_tex[i]);
+    }
+    nme_impostor_col_hit = texture_main_col(&nme_tex_hit);
+#endif
 }
 
-static void init_single_trail(Trail* trail, fix16_t z) {
-    vec3_set(&trail->pos0, sym_random_fix(F16(100.0)) + ship_x, sym_random_fix(F16(100.0)) + ship_y, z);
-    trail->spd = fix16_mul(F16(2.5) + rnd_fix(F16(5.0)), game_spd);
-    trail->col = flr_fix(rnd_fix(F16(4.0))) + 1;
+static void init_single_trail(int i, fix16_t z) {
+    // y is drawn first, matching GCC's right-to-left argument order in the
+    // vec3_set() call this replaced, so the RNG sequence is unchanged
+    trails.y0[i] = sym_random_fix(F16(100.0)) + ship_y;
+    trails.x0[i] = sym_random_fix(F16(100.0)) + ship_x;
+    trails.z0[i] = z;
+    trails.spd[i] = fix16_mul(F16(2.5) + rnd_fix(F16(5.0)), game_spd);
+    trails.col[i] = flr_fix(rnd_fix(F16(4.0))) + 1;
 }
 
 static void init_trail(void) {
     for (int i = 0; i < MAX_TRAILS; i++) {
-        init_single_trail(&trails[i], sym_random_fix(F16(150.0)));
+        init_single_trail(i, sym_random_fix(F16(150.0)));
     }
 }
 
-static void init_single_bg(Background* bg, fix16_t z) {
+static void init_single_bg(int i, fix16_t z) {
     fix16_t a = rnd_fix(fix16_one);
     fix16_t r = F16(150.0) + rnd_fix(F16(150.0));
     fix16_t angle = fix16_mul(a, FIX_TWO_PI);
+    fix16_t sin_a, cos_a;
+    fix16_sincos(angle, &sin_a, &cos_a);
     // PICO-8's sin is negative of standard sin
-    vec3_set(&bg->pos, fix16_mul(r, fix16_cos(angle)), fix16_mul(r, -fix16_sin(angle)), z);
-    bg->spd = F16(0.05) + rnd_fix(F16(0.05));
+    bgs.x[i] = fix16_mul(r, cos_a);
+    bgs.y[i] = fix16_mul(r, -sin_a);
+    bgs.z[i] = z;
+    bgs.spd[i] = F16(0.05) + rnd_fix(F16(0.05));
     if (flr_fix(rnd_fix(F16(6.0))) == 0) {
-        bg->index = 8 + (int)rnd_fix(F16(8.0));
+        bgs.index[i] = 8 + (int)rnd_fix(F16(8.0));
     } else {
-        bg->index = -bg_color[get_random_idx(3)];
+        bgs.index[i] = -bg_color[get_random_idx(3)];
     }
 }
 
 static void init_bg(void) {
     for (int i = 0; i < MAX_BGS; i++) {
-        init_single_bg(&bgs[i], sym_random_fix(F16(400.0)));
+        init_single_bg(i, sym_random_fix(F16(400.0)));
     }
 }
 
@@ -920,6 +1622,10 @@ static void init_main(void) {
     // Save persistent data to flash when returning to title
     save_cart_data();
 
+    if (nme_proj_high_water > 0) {
+        printf("Enemy projection pool: high water %d/%d\n", nme_proj_high_water, MAX_ENEMIES);
+    }
+
     cur_mode = 0;
     cam_angle_z = F16(-0.4);
     cam_angle_x = fix16_mul(fix16_from_int(flr_fix(rnd_fix(FIX_TWO)) * 2 - 1), F16(0.03) + rnd_fix(F16(0.1)));
@@ -933,8 +1639,9 @@ static void init_main(void) {
     life = 4;
     barrel_cur_t = F16(-1.0);
     num_enemies = 0;
-    num_lasers = 0;
-    num_nme_lasers = 0;
+    nme_proj_reset();
+    lasers.count = 0;
+    nme_lasers.count = 0;
     hit_t = -1;
     laser_on = false;
     nb_nme_ship = 0;
@@ -959,19 +1666,57 @@ static void init_main(void) {
 // Laser Management
 // ============================================================================
 
-static Laser* spawn_laser(Laser* lasers_arr, int* count, Vec3 pos) {
-    if (*count >= MAX_LASERS) return NULL;
-    Laser* laser = &lasers_arr[*count];
-    vec3_copy(&laser->pos0, &pos);
-    (*count)++;
-    return laser;
+// Returns the new laser's index, or -1 when the list is full
+static int spawn_laser(LaserList* list, Vec3 pos) {
+    if (list->count >= MAX_LASERS) return -1;
+    int i = list->count++;
+    list->x0[i] = pos.x;
+    list->y0[i] = pos.y;
+    list->z0[i] = pos.z;
+    return i;
 }
 
-static void remove_laser(Laser* lasers_arr, int* count, int idx) {
-    if (idx < *count - 1) {
-        lasers_arr[idx] = lasers_arr[*count - 1];
+static void laser_copy(LaserList* list, int dst, int src) {
+    list->x0[dst] = list->x0[src]; list->y0[dst] = list->y0[src]; list->z0[dst] = list->z0[src];
+    list->x1[dst] = list->x1[src]; list->y1[dst] = list->y1[src]; list->z1[dst] = list->z1[src];
+    list->spd_x[dst] = list->spd_x[src]; list->spd_y[dst] = list->spd_y[src]; list->spd_z[dst] = list->spd_z[src];
+}
+
+static void laser_swap(LaserList* list, int a, int b) {
+    fix16_t* cols[9] = {
+        list->x0, list->y0, list->z0, list->x1, list->y1, list->z1,
+        list->spd_x, list->spd_y, list->spd_z
+    };
+    for (int c = 0; c < 9; c++) {
+        fix16_t t = cols[c][a];
+        cols[c][a] = cols[c][b];
+        cols[c][b] = t;
+    }
+}
+
+// Keeps the remaining lasers in order (the lists are z-sorted)
+static void remove_lasers(LaserList* list, int idx, int n) {
+    if (n <= 0) return;
+    for (int i = idx; i + n < list->count; i++) {
+        laser_copy(list, i, i + n);
+    }
+    list->count -= n;
+}
+
+static void remove_laser(LaserList* list, int idx) {
+    remove_lasers(list, idx, 1);
+}
+
+// Insertion sort by z0, ascending. Lasers move together and are spawned at
+// the near end, so the list is almost always already sorted and this is a
+// single linear pass.
+static void sort_lasers(LaserList* list) {
+    for (int i = 1; i < list->count; i++) {
+        if (list->z0[i - 1] <= list->z0[i]) continue;
+        for (int j = i; j > 0 && list->z0[j - 1] > list->z0[j]; j--) {
+            laser_swap(list, j - 1, j);
+        }
     }
-    (*count)--;
 }
 
 // ============================================================================
@@ -980,11 +1725,13 @@ static void remove_laser(Laser* lasers_arr, int* count, int idx) {
 
 static Enemy* spawn_nme(int type, Vec3 pos) {
     if (num_enemies >= MAX_ENEMIES) return NULL;
+    Vec3* proj = nme_proj_acquire(nme_meshes[type - 1].num_vertices);
+    if (proj == NULL) return NULL;
     Enemy* nme = &enemies[num_enemies];
     memset(nme, 0, sizeof(Enemy));
     vec3_copy(&nme->pos, &pos);
     nme->type = type;
-    nme->proj = (Vec3*)calloc(nme_meshes[type - 1].num_vertices, sizeof(Vec3));
+    nme->proj = proj;
     nme->life = nme_life[type - 1];
     nme->hit_t = -1;
     num_enemies++;
@@ -1119,8 +1866,8 @@ static void update_enemies(void) {
                                         laser_pos = nme->pos;
                                     }
 
-                                    Laser* laser = spawn_laser(nme_lasers, &num_nme_lasers, laser_pos);
-                                    if (laser) {
+                                    int l = spawn_laser(&nme_lasers, laser_pos);
+                                    if (l >= 0) {
                                         Vec3 target = {
                                             ship_x + fix16_mul(nme->laser_offset_x[j], ratio) + sym_random_fix(F16(5.0)),
                                             ship_y + fix16_mul(nme->laser_offset_y[j], ratio) + sym_random_fix(F16(5.0)),
@@ -1130,18 +1877,18 @@ static void update_enemies(void) {
                                         vec3_mul(&ldir, F16(0.1));
                                         fix16_t len = vec3_length(&ldir);
                                         fix16_t v = (len > F16(0.001)) ? fix16_div(fix16_mul(FIX_TWO, game_spd), len) : fix16_mul(FIX_TWO, game_spd);
-                                        laser->spd.x = fix16_mul(ldir.x, v);
-                                        laser->spd.y = fix16_mul(ldir.y, v);
-                                        laser->spd.z = fix16_mul(ldir.z, v);
+                                        nme_lasers.spd_x[l] = fix16_mul(ldir.x, v);
+                                        nme_lasers.spd_y[l] = fix16_mul(ldir.y, v);
+                                        nme_lasers.spd_z[l] = fix16_mul(ldir.z, v);
                                     }
                                 }
                             } else {
                                 Vec3 laser_pos = {nme->pos.x, nme->pos.y, nme->pos.z + F16(12.0)};
-                                Laser* laser = spawn_laser(nme_lasers, &num_nme_lasers, laser_pos);
-                                if (laser) {
-                                    laser->spd.x = sym_random_fix(F16(0.05));
-                                    laser->spd.y = sym_random_fix(F16(0.05));
-                                    laser->spd.z = fix16_mul(FIX_TWO, game_spd);
+                                int l = spawn_laser(&nme_lasers, laser_pos);
+                                if (l >= 0) {
+                                    nme_lasers.spd_x[l] = sym_random_fix(F16(0.05));
+                                    nme_lasers.spd_y[l] = sym_random_fix(F16(0.05));
+                                    nme_lasers.spd_z[l] = fix16_mul(FIX_TWO, game_spd);
                                 }
                             }
                         }
@@ -1168,7 +1915,7 @@ static void update_enemies(void) {
 
         if (del) {
             if (nme->type > 1) nb_nme_ship--;
-            if (nme->proj) free(nme->proj);
+            nme_proj_release(nme->proj);
             enemies[i] = enemies[num_enemies - 1];
             num_enemies--;
             i--;
@@ -1205,19 +1952,26 @@ static void update_enemies(void) {
 }
 
 static void update_nme_lasers(void) {
-    for (int i = 0; i < num_nme_lasers; i++) {
-        Laser* laser = &nme_lasers[i];
-        vec3_copy(&laser->pos1, &laser->pos0);
-        laser->pos0.x += laser->spd.x;
-        laser->pos0.y += laser->spd.y;
-        laser->pos0.z += laser->spd.z;
-
-        if (laser->pos0.z >= 0) {
-            hit_ship(&laser->pos0, F16(1.5));
-            hit_ship(&laser->pos1, F16(1.5));
-            remove_laser(nme_lasers, &num_nme_lasers, i);
-            i--;
-        }
+    LaserList* l = &nme_lasers;
+    for (int i = 0; i < l->count; i++) {
+        l->x1[i] = l->x0[i];
+        l->y1[i] = l->y0[i];
+        l->z1[i] = l->z0[i];
+        l->x0[i] += l->spd_x[i];
+        l->y0[i] += l->spd_y[i];
+        l->z0[i] += l->spd_z[i];
+    }
+
+    // Only the nearest lasers (the tail of the sorted list) can have
+    // reached the ship plane
+    sort_lasers(l);
+    while (l->count > 0 && l->z0[l->count - 1] >= 0) {
+        int i = l->count - 1;
+        Vec3 pos0 = {l->x0[i], l->y0[i], l->z0[i]};
+        Vec3 pos1 = {l->x1[i], l->y1[i], l->z1[i]};
+        hit_ship(&pos0, F16(1.5));
+        hit_ship(&pos1, F16(1.5));
+        l->count--;
     }
 }
 
@@ -1231,75 +1985,79 @@ static void update_lasers(void) {
         Vec3 pos = {fix16_from_int(cur_laser_side), F16(-1.5), F16(-8.0)};
         Vec3 world_pos;
         mat_mul_pos(&world_pos, &ship_mat, &pos);
-        spawn_laser(lasers, &num_lasers, world_pos);
+        spawn_laser(&lasers, world_pos);
         cur_laser_side = -cur_laser_side;
     }
 
-    for (int i = 0; i < num_lasers; i++) {
-        Laser* laser = &lasers[i];
-        vec3_copy(&laser->pos1, &laser->pos0);
-        laser->pos0.z -= F16(5.0);
-
-        if (laser->pos0.z <= F16(-200.0)) {
-            remove_laser(lasers, &num_lasers, i);
-            i--;
-        }
+    for (int i = 0; i < lasers.count; i++) {
+        lasers.x1[i] = lasers.x0[i];
+        lasers.y1[i] = lasers.y0[i];
+        lasers.z1[i] = lasers.z0[i];
+        lasers.z0[i] -= F16(5.0);
     }
+
+    // Expired lasers are the farthest ones, at the head of the sorted list
+    sort_lasers(&lasers);
+    int expired = 0;
+    while (expired < lasers.count && lasers.z0[expired] <= F16(-200.0)) expired++;
+    remove_lasers(&lasers, 0, expired);
 }
 
 static void update_trail(void) {
     for (int i = 0; i < MAX_TRAILS; i++) {
-        Trail* trail = &trails[i];
-        if (trail->pos0.z >= F16(150.0)) {
-            init_single_trail(trail, F16(-150.0));
+        if (trails.z0[i] >= F16(150.0)) {
+            init_single_trail(i, F16(-150.0));
         }
-        vec3_copy(&trail->pos1, &trail->pos0);
-        trail->pos0.z += trail->spd;
+        trails.x1[i] = trails.x0[i];
+        trails.y1[i] = trails.y0[i];
+        trails.z1[i] = trails.z0[i];
+        trails.z0[i] += trails.spd[i];
     }
 
     for (int i = 0; i < MAX_BGS; i++) {
-        Background* bg = &bgs[i];
-        bg->pos.z += fix16_mul(bg->spd, game_spd);
-        if (bg->pos.z >= F16(400.0)) {
-            init_single_bg(bg, F16(-400.0));
+        bgs.z[i] += fix16_mul(bgs.spd[i], game_spd);
+        if (bgs.z[i] >= F16(400.0)) {
+            init_single_bg(i, F16(-400.0));
         }
     }
 }
 
+// Sweep over both z-sorted arrays: enemies far to near, lasers far to near.
+// A laser covers [z0, z1] this frame, and every player laser has
+// the same length, so both ends are sorted. Lasers whose near end is behind
+// the current enemy can't hit it or any nearer enemy and are skipped for
+// good; for each enemy only the lasers overlapping its z are tested.
 static void update_collisions(void) {
-    int laser_idx = 0;
-    int nme_idx = num_enemies - 1;
+    int first = 0;
 
-    while (laser_idx < num_lasers && nme_idx >= 0) {
-        Vec3* laser_pos0 = &lasers[laser_idx].pos0;
-        Vec3* laser_pos1 = &lasers[laser_idx].pos1;
+    for (int nme_idx = num_enemies - 1; nme_idx >= 0 && first < lasers.count; nme_idx--) {
         Enemy* nme = &enemies[nme_idx];
         fix16_t nme_z = nme->pos.z;
 
-        if (nme_z > laser_pos1->z) {
-            laser_idx++;
-        } else {
-            if (nme->life > 0 && nme_z >= laser_pos0->z) {
-                fix16_t dx = fix16_mul(laser_pos0->x - nme->pos.x, F16(0.2));
-                fix16_t dy = fix16_mul(laser_pos0->y - nme->pos.y, F16(0.2));
-
-                fix16_t radius = nme_radius[nme->type - 1];
-                if (fix16_mul(dx, dx) + fix16_mul(dy, dy) <= fix16_mul(fix16_mul(radius, radius), F16(0.04))) {
-                    nme->life--;
-                    if (nme->life == 0) {
-                        nme->hit_t = -1;
-                        sfx(2, 1);
-                        score += nme_score[nme->type - 1];
-                    } else {
-                        vec3_copy(&nme->hit_pos, laser_pos0);
-                        nme->hit_t = 0;
-                        sfx(5, 1);
-                    }
-                    remove_laser(lasers, &num_lasers, laser_idx);
-                    continue;
+        while (first < lasers.count && lasers.z1[first] < nme_z) first++;
+
+        for (int laser_idx = first; laser_idx < lasers.count && nme->life > 0;) {
+            if (lasers.z0[laser_idx] > nme_z) break;  // This and all further lasers start in front
+
+            fix16_t dx = fix16_mul(lasers.x0[laser_idx] - nme->pos.x, F16(0.2));
+            fix16_t dy = fix16_mul(lasers.y0[laser_idx] - nme->pos.y, F16(0.2));
+
+            fix16_t radius = nme_radius[nme->type - 1];
+            if (fix16_mul(dx, dx) + fix16_mul(dy, dy) <= fix16_mul(fix16_mul(radius, radius), F16(0.04))) {
+                nme->life--;
+                if (nme->life == 0) {
+                    nme->hit_t = -1;
+                    sfx(2, 1);
+                    score += nme_score[nme->type - 1];
+                } else {
+                    vec3_set(&nme->hit_pos, lasers.x0[laser_idx], lasers.y0[laser_idx], lasers.z0[laser_idx]);
+                    nme->hit_t = 0;
+                    sfx(5, 1);
                 }
+                remove_laser(&lasers, laser_idx);
+                continue;
             }
-            nme_idx--;
+            laser_idx++;
         }
     }
 }
@@ -1480,14 +2238,24 @@ static void game_update(void) {
     }
 
     // Build camera matrix
+    Mat34 cam;
+#ifdef HYPERSPACE_CXX_MATH
+    fx::store(cam, fx::translate(fx::Zero{}, fx::Zero{}, -cam_depth) * fx::rotx(cam_angle_x) *
+                   fx::roty(cam_angle_z) * fx::translate(-cam_x, -cam_y, fx::Zero{}));
+#else
     Mat34 trans, rot;
     mat_translation(&trans, 0, 0, -cam_depth);
     mat_rotx(&rot, cam_angle_x);
-    mat_mul(&cam_mat, &trans, &rot);
+    mat_mul(&cam, &trans, &rot);
     mat_roty(&rot, cam_angle_z);
-    mat_mul(&cam_mat, &cam_mat, &rot);
+    mat_mul(&cam, &cam, &rot);
     mat_translation(&trans, -cam_x, -cam_y, 0);
-    mat_mul(&cam_mat, &cam_mat, &trans);
+    mat_mul(&cam, &cam, &trans);
+#endif
+    if (memcmp(&cam, &cam_mat, sizeof(cam)) != 0) {
+        cam_mat = cam;
+        cam_serial++;
+    }
 
     // Roll/pitch noise
     cur_noise_t += fix16_one;
@@ -1524,11 +2292,16 @@ static void game_update(void) {
 
     roll_angle = normalize_angle(roll_angle);
 
+#ifdef HYPERSPACE_CXX_MATH
+    fx::store(ship_mat, fx::translate(ship_x, ship_y, fx::Zero{}) * fx::rotx(normalize_angle(pitch_angle + noise_pitch)) *
+                        fx::rotz(normalize_angle(roll_angle + noise_roll)));
+#else
     mat_translation(&ship_pos_mat, ship_x, ship_y, 0);
     mat_rotx(&rot, normalize_angle(pitch_angle + noise_pitch));
     mat_mul(&ship_mat, &ship_pos_mat, &rot);
     mat_rotz(&rot, normalize_angle(roll_angle + noise_roll));
     mat_mul(&ship_mat, &ship_mat, &rot);
+#endif
 
     mat_transpose_rot(&inv_ship_mat, &ship_mat);
 
@@ -1546,6 +2319,14 @@ static void game_update(void) {
         if (hit_t > 15) hit_t = -1;
     }
 
+#ifdef HYPERSPACE_CXX_MATH
+    // ship_x/y are not changed by the updates above
+    fx::store(ship_mat, fx::dense(cam_mat) * fx::dense(ship_mat));
+    fx::store(ship_pos_mat, fx::dense(cam_mat) * fx::translate(ship_x, ship_y, fx::Zero{}));
+
+    fx::store(light_mat, light_tilt * fx::roty(F16(0.34) + fix16_mul(global_t, F16(0.003))));
+    fx::store_rot(light_dir, fx::dense(light_mat), fx::vec(fx::Zero{}, fx::Zero{}, -fix16_one));
+#else
     mat_mul(&ship_mat, &cam_mat, &ship_mat);
     mat_mul(&ship_pos_mat, &cam_mat, &ship_pos_mat);
 
@@ -1554,6 +2335,7 @@ static void game_update(void) {
     mat_mul(&light_mat, &light_mat, &rot);
     Vec3 light_src = {0, 0, -fix16_one};
     mat_mul_vec(&light_dir, &light_mat, &light_src);
+#endif
 
     mat_mul_vec(&ship_light_dir, &inv_ship_mat, &light_dir);
 
@@ -1574,6 +2356,28 @@ static void game_update(void) {
 // Rendering
 // ============================================================================
 
+// Conservative test of an enemy's bounding sphere against the 128x128 view.
+// Returning false guarantees rasterize_tri() would reject every triangle:
+// either all vertices are too near or behind (proj z == 0), or all of them
+// project past the same screen edge. The edge planes are x = +-0.8 w and
+// y = +-0.8 w (w = -z, 64px / 80), i.e. normals (5, 0, +-4) of length
+// sqrt(41) < 6.5. The sides are only tested with the sphere entirely at
+// w >= 8, where every vertex projects with a valid positive scale.
+static bool nme_in_frustum(const Vec3* pos, fix16_t radius) {
+    Vec3 c;
+    mat_mul_pos(&c, &cam_mat, pos);
+
+    if (c.z - radius > F16(-7.0)) return false;
+    if (c.z + radius > F16(-8.0)) return true;
+
+    fix16_t r = fix16_mul(radius, F16(6.5)) + fix16_one;
+    if (5 * c.x - 4 * c.z + r < 0) return false;  // Left
+    if (5 * c.x + 4 * c.z - r > 0) return false;  // Right
+    if (5 * c.y + 4 * c.z - r > 0) return false;  // Top
+    if (5 * c.y - 4 * c.z + r < 0) return false;  // Bottom
+    return true;
+}
+
 static void transform_vert(void) {
     for (int i = 0; i < ship_mesh.num_vertices; i++) {
         transform_pos(&ship_mesh.projected[i], &ship_mat, &ship_mesh.vertices[i]);
@@ -1592,23 +2396,84 @@ static void transform_vert(void) {
 
         for (int i = 0; i < num_enemies; i++) {
             Enemy* nme = &enemies[i];
+            Mesh* mesh = &nme_meshes[nme->type - 1];
 
-            Mat34 nme_mat, nme_rot_x, nme_rot_z, inv_nme_mat;
-            mat_translation(&nme_mat, nme->pos.x, nme->pos.y, nme->pos.z);
-            mat_rotx(&nme_rot_x, nme->rot_x);
-            mat_mul(&nme_mat, &nme_mat, &nme_rot_x);
-            mat_rotz(&nme_rot_z, nme->rot_y);
-            mat_mul(&nme_mat, &nme_mat, &nme_rot_z);
+            // Dying enemies scatter explosions over all their vertices, so
+            // only live ones are culled
+            nme->visible = nme->life <= 0 || nme_in_frustum(&nme->pos, nme_cull_radius[nme->type - 1]);
+
+            NmeTransform* xf = &nme_xform_pool[nme_proj_slot(nme->proj)];
+            bool rot_dirty = !xf->valid || nme->rot_x != xf->rot_x || nme->rot_y != xf->rot_y;
+            bool pos_dirty = !xf->valid || nme->pos.x != xf->model.m[3] ||
+                             nme->pos.y != xf->model.m[7] || nme->pos.z != xf->model.m[11];
+            bool cam_dirty = !xf->valid || xf->cam_serial != cam_serial;
+            xf->valid = true;
+
+            // The translation only sets column 3 of the model matrix and
+            // adds to column 3 of the view matrix, so moving alone skips the
+            // rotations and recomputes just that column. Multiplying by 0
+            // or 1 is exact, so the results match the full chain bit for bit.
+            if (rot_dirty) {
+#ifdef HYPERSPACE_CXX_MATH
+                fx::store(xf->model, fx::rotx(nme->rot_x) * fx::rotz(nme->rot_y));
+#else
+                Mat34 nme_rot_x, nme_rot_z;
+                mat_rotx(&nme_rot_x, nme->rot_x);
+                mat_rotz(&nme_rot_z, nme->rot_y);
+                mat_mul(&xf->model, &nme_rot_x, &nme_rot_z);
+#endif
+                xf->rot_x = nme->rot_x;
+                xf->rot_y = nme->rot_y;
+            }
+            if (rot_dirty || pos_dirty) {
+                xf->model.m[3] = nme->pos.x;
+                xf->model.m[7] = nme->pos.y;
+                xf->model.m[11] = nme->pos.z;
+            }
+            if (rot_dirty || cam_dirty) {
+#ifdef HYPERSPACE_CXX_MATH
+                fx::store(xf->view, fx::dense(cam_mat) * fx::dense(xf->model));
+#else
+                mat_mul(&xf->view, &cam_mat, &xf->model);
+#endif
+                xf->cam_serial = cam_serial;
+            } else if (pos_dirty) {
+                Vec3 t;
+                mat_mul_pos(&t, &cam_mat, &nme->pos);
+                xf->view.m[3] = t.x;
+                xf->view.m[7] = t.y;
+                xf->view.m[11] = t.z;
+            }
 
-            mat_transpose_rot(&inv_nme_mat, &nme_mat);
-            mat_mul_vec(&nme->light_dir, &inv_nme_mat, &light_dir);
+            const Mesh* xform = mesh;
+            int num_vertices = 1;
+            if (nme->visible) {
+                // light_dir turns every frame, so this is not cached
+#ifdef HYPERSPACE_CXX_MATH
+                fx::store_rot(nme->light_dir, fx::transpose_rot(fx::dense(xf->model)), light_dir);
+#else
+                Mat34 inv_nme_mat;
+                mat_transpose_rot(&inv_nme_mat, &xf->model);
+                mat_mul_vec(&nme->light_dir, &inv_nme_mat, &light_dir);
+#endif
 
-            Mat34 final_nme_mat;
-            mat_mul(&final_nme_mat, &cam_mat, &nme_mat);
+#ifdef HYPERSPACE_MESH_LOD
+                nme->draw_mesh = nme_lod_mesh(nme, xf->view.m[11]);
+#else
+                nme->draw_mesh = mesh;
+#endif
+                // Every mesh level starts with the same vertex 0, and an
+                // impostor needs only that one
+                if (nme->draw_mesh) {
+                    xform = nme->draw_mesh;
+                    num_vertices = xform->num_vertices;
+                }
+            }
+            // Vertex 0 is not the mesh origin: auto-aim needs it exact, so
+            // a culled enemy still projects it, but nothing else
 
-            Mesh* mesh = &nme_meshes[nme->type - 1];
-            for (int j = 0; j < mesh->num_vertices; j++) {
-                transform_pos(&nme->proj[j], &final_nme_mat, &mesh->vertices[j]);
+            for (int j = 0; j < num_vertices; j++) {
+                transform_pos(&nme->proj[j], &xf->view, &xform->vertices[j]);
             }
 
             if (nme->life > 0) {
@@ -1638,31 +2503,76 @@ static void transform_vert(void) {
     transform_pos(&star_proj, &ship_pos_mat, &star_pos);
 }
 
-static void draw_explosion(Vec3* proj, fix16_t size) {
+static void explosion_circle(const Vec3* proj, fix16_t size, RenderCircle* c) {
     fix16_t invz = proj->z;
-    int col = explosion_color[get_random_idx(4)];
-    circfill(fix16_to_int(proj->x + fix16_mul(sym_random_fix(fix16_mul(size, FIX_HALF)), invz)),
-             fix16_to_int(proj->y + fix16_mul(sym_random_fix(fix16_mul(size, FIX_HALF)), invz)),
-             fix16_to_int(fix16_mul(invz, size + rnd_fix(size))), col);
+    c->col = explosion_color[get_random_idx(4)];
+    c->x = fix16_to_int(proj->x + fix16_mul(sym_random_fix(fix16_mul(size, FIX_HALF)), invz));
+    c->y = fix16_to_int(proj->y + fix16_mul(sym_random_fix(fix16_mul(size, FIX_HALF)), invz));
+    c->r = fix16_to_int(fix16_mul(invz, size + rnd_fix(size)));
+}
+
+static void draw_explosion(const Vec3* proj, fix16_t size) {
+    RenderCircle c;
+    explosion_circle(proj, size, &c);
+    circfill(c.x, c.y, c.r, c.col);
+}
+
+// One glyph with its shadow layers. A glyph's shadows only reach into the
+// top layer of the next glyph or line, which is drawn later and wins, so
+// drawing glyph by glyph gives the same pixels as three passes over the
+// string (shadows, then mids, then tops).
+static void print_char_3d(char c, int x, int y) {
+    if ((unsigned char)c < 32 || (unsigned char)c > 127) return;
+    int idx = c - 32;
+
+    if (!glyph_cell_visible(x, y, 5, 7)) {
+        print_char(c, x + 2, y + 2, 1);
+        print_char(c, x + 1, y + 1, 13);
+        print_char(c, x, y, 7);
+        return;
+    }
+
+    uint8_t top = palette_map[7], mid = palette_map[13], shadow = palette_map[1];
+    for (int row = 0; row < 7; row++) {
+        const Glyph3DRow* g = &glyph_3d[idx][row];
+        uint32_t bits = g->top | g->mid | g->shadow;
+        if (bits == 0) continue;
+        uint8_t* dst = screen[y + row];
+        for (int i = 0; i < 5; i++) {
+            uint8_t bit = (uint8_t)(0x10 >> i);
+            if (g->top & bit) screen_put(dst, x + i, top);
+            else if (g->mid & bit) screen_put(dst, x + i, mid);
+            else if (g->shadow & bit) screen_put(dst, x + i, shadow);
+        }
+        mark_dirty(x + __builtin_clz(bits) - 27, x + 4 - __builtin_ctz(bits), y + row);
+    }
 }
 
 static void print_3d(const char* str, int x, int y) {
-    print_str(str, x + 2, y + 2, 1);
-    print_str(str, x + 1, y + 1, 13);
-    print_str(str, x, y, 7);
+    int cx = x;
+    while (*str) {
+        if (*str == '\n') {
+            y += 6;
+            cx = x;
+        } else {
+            print_char_3d(*str, cx, y);
+            cx += 4;
+        }
+        str++;
+    }
 }
 
-static void draw_lasers(Laser* in_lasers, int count, int col) {
-    Vec3 p0, p1;
+static void draw_lasers(const LaserList* list, int col) {
+    ProjBatch* p0 = &proj_batch[0];
+    ProjBatch* p1 = &proj_batch[1];
     color(col);
 
-    for (int i = 0; i < count; i++) {
-        Laser* laser = &in_lasers[i];
-        transform_pos(&p0, &cam_mat, &laser->pos0);
-        transform_pos(&p1, &cam_mat, &laser->pos1);
+    transform_points(&cam_mat, list->x0, list->y0, list->z0, p0->x, p0->y, p0->z, list->count);
+    transform_points(&cam_mat, list->x1, list->y1, list->z1, p1->x, p1->y, p1->z, list->count);
 
-        if (p0.z > 0 && p1.z > 0) {
-            line(fix16_to_int(p0.x), fix16_to_int(p0.y), fix16_to_int(p1.x), fix16_to_int(p1.y), col);
+    for (int i = 0; i < list->count; i++) {
+        if (p0->z[i] > 0 && p1->z[i] > 0) {
+            line(fix16_to_int(p0->x[i]), fix16_to_int(p0->y[i]), fix16_to_int(p1->x[i]), fix16_to_int(p1->y[i]), col);
         }
     }
 }
@@ -1714,21 +2624,26 @@ static void game_draw(void) {
     Vec3 p0, p1;
 
     cls();
+    PROF_BEGIN(PROF_TRANSFORM);
     transform_vert();
+    PROF_END(PROF_TRANSFORM);
 
     // Draw backgrounds
+    PROF_BEGIN(PROF_BACKGROUND);
+    ProjBatch* bp0 = &proj_batch[0];
+    ProjBatch* bp1 = &proj_batch[1];
+    transform_points(&ship_pos_mat, bgs.x, bgs.y, bgs.z, bp0->x, bp0->y, bp0->z, MAX_BGS);
     for (int i = 0; i < MAX_BGS; i++) {
-        Background* bg = &bgs[i];
-        transform_pos(&p0, &ship_pos_mat, &bg->pos);
-
-        if (p0.z > 0) {
-            int index = bg->index;
+        if (bp0->z[i] > 0) {
+            int index = bgs.index[i];
+            int x = fix16_to_int(bp0->x[i]);
+            int y = fix16_to_int(bp0->y[i]);
             if (index > 0) {
-                spr(index + 16 * flr_fix(rnd_fix(FIX_TWO)), fix16_to_int(p0.x), fix16_to_int(p0.y), 1, 1);
+                spr(index + 16 * flr_fix(rnd_fix(FIX_TWO)), x, y, 1, 1);
             } else {
                 int col = 7;
                 if (rnd_fix(fix16_one) > FIX_HALF) col = -index;
-                pset(fix16_to_int(p0.x), fix16_to_int(p0.y), col);
+                pset(x, y, col);
             }
         }
     }
@@ -1743,21 +2658,23 @@ static void game_draw(void) {
 
     // Draw trails
     fix16_t trail_color_coef = F16(2.25);  // 0.45 * 5
+    transform_points(&cam_mat, trails.x0, trails.y0, trails.z0, bp0->x, bp0->y, bp0->z, MAX_TRAILS);
+    transform_points(&cam_mat, trails.x1, trails.y1, trails.z1, bp1->x, bp1->y, bp1->z, MAX_TRAILS);
     for (int i = 0; i < MAX_TRAILS; i++) {
-        Trail* trail = &trails[i];
-        transform_pos(&p0, &cam_mat, &trail->pos0);
-        transform_pos(&p1, &cam_mat, &trail->pos1);
-
-        if (p0.z > 0 && p1.z > 0) {
-            int index = fix16_to_int(mid_fix(fix16_from_int(trail->col), fix16_div(trail_color_coef, p0.z) + fix16_one, F16(5.0))) - 1;
+        if (bp0->z[i] > 0 && bp1->z[i] > 0) {
+            int index = fix16_to_int(mid_fix(fix16_from_int(trails.col[i]), fix16_div(trail_color_coef, bp0->z[i]) + fix16_one, F16(5.0))) - 1;
             if (index < 0) index = 0;
             if (index > 4) index = 4;
-            line(fix16_to_int(p0.x), fix16_to_int(p0.y), fix16_to_int(p1.x), fix16_to_int(p1.y), trail_color[index]);
+            line(fix16_to_int(bp0->x[i]), fix16_to_int(bp0->y[i]), fix16_to_int(bp1->x[i]), fix16_to_int(bp1->y[i]), trail_color[index]);
         }
     }
+    PROF_END(PROF_BACKGROUND);
 
-    // Draw enemies
+    // Draw enemies: queue every triangle and explosion, then draw them all
+    // back to front
+    PROF_BEGIN(PROF_ENEMIES);
     if (cur_mode == 2) {
+        rq_reset();
         for (int i = num_enemies - 1; i >= 0; i--) {
             Enemy* nme = &enemies[i];
             Mesh* mesh = &nme_meshes[nme->type - 1];
@@ -1770,33 +2687,41 @@ static void game_draw(void) {
                     if (((-nme->life) & 1) == 0) cur_tex = &nme_tex_hit;
                     for (int j = 0; j < 3; j++) {
                         int idx = get_random_idx(mesh->num_vertices);
-                        draw_explosion(&nme->proj[idx], size);
+                        rq_push_explosion(&nme->proj[idx], size);
                     }
                 } else {
                     fix16_t ratio = FIX_HALF + fix16_div(F16(6.0) - fix16_from_int(nme->hit_t), F16(12.0));
                     fix16_t size = fix16_mul(ratio, F16(3.0));
                     if ((nme->hit_t & 1) == 0) cur_tex = &nme_tex_hit;
                     transform_pos(&p0, &cam_mat, &nme->hit_pos);
-                    draw_explosion(&p0, size);
+                    rq_push_explosion(&p0, size);
                 }
             }
 
-            if (cur_tex) {
-                t_light_dir = &nme->light_dir;
-                for (int j = 0; j < mesh->num_triangles; j++) {
-                    rasterize_tri(j, mesh->triangles, nme->proj);
-                }
+            rq_nme_tex[i] = cur_tex;
+            if (nme->visible) {
+                if (nme->draw_mesh) rq_push_mesh(nme->draw_mesh, nme->proj, i);
+#ifdef HYPERSPACE_MESH_LOD
+                else rq_push_impostor(nme, cur_tex);
+#endif
             }
         }
+        rq_sort();
+        rq_draw();
     }
 
+    PROF_END(PROF_ENEMIES);
+
     // Draw enemy lasers
-    draw_lasers(nme_lasers, num_nme_lasers, 8);
+    PROF_BEGIN(PROF_LASERS);
+    draw_lasers(&nme_lasers, 8);
 
     // Draw player lasers
-    draw_lasers(lasers, num_lasers, 11);
+    draw_lasers(&lasers, 11);
+    PROF_END(PROF_LASERS);
 
     // Draw aim
+    PROF_BEGIN(PROF_SHIP);
     if (cur_mode == 2) {
         int idx = 97;
         if (tgt_pos) {
@@ -1822,7 +2747,9 @@ static void game_draw(void) {
     if (laser_spawned) cur_tex = &ship_tex_laser_lit;
     else cur_tex = &ship_tex;
 
-    sort_tris(ship_mesh.triangles, ship_mesh.num_triangles, ship_mesh.projected);
+    rq_reset();
+    rq_push_mesh(&ship_mesh, ship_mesh.projected, RQ_OWNER_SHIP);
+    rq_sort();
 
     if (hit_t != -1) {
         transform_pos(&p0, &cam_mat, &hit_pos);
@@ -1841,9 +2768,7 @@ static void game_draw(void) {
     t_light_dir = &ship_light_dir;
     set_ngn_pal();
 
-    for (int i = 0; i < ship_mesh.num_triangles; i++) {
-        rasterize_tri(i, ship_mesh.triangles, ship_mesh.projected);
-    }
+    rq_draw();
 
     pal_reset();
 
@@ -1851,8 +2776,10 @@ static void game_draw(void) {
     if (star_visible) {
         draw_lens_flare();
     }
+    PROF_END(PROF_SHIP);
 
     // Draw HUD
+    PROF_BEGIN(PROF_HUD);
     if (cur_mode == 2) {
         char buf[32];
         snprintf(buf, sizeof(buf), "SCORE %d", score);
@@ -1891,6 +2818,7 @@ static void game_draw(void) {
         Vec3 center = {FIX_SCREEN_CENTER, FIX_SCREEN_CENTER, fix16_one};
         draw_explosion(&center, fade_ratio);
     }
+    PROF_END(PROF_HUD);
 }
 
 // ============================================================================
@@ -1906,6 +2834,7 @@ static void game_draw(void) {
 static void load_embedded_data(void) {
     // Copy embedded spritesheet data
     memcpy(spritesheet, hyperspace_spritesheet, sizeof(spritesheet));
+    spr_cache_init();
     // Copy embedded map data (mesh definitions)
     memcpy(map_memory, hyperspace_map, sizeof(map_memory));
 }
@@ -1919,6 +2848,7 @@ static void load_embedded_data(void) {
 
 static void game_init(void) {
     pal_reset();
+    init_glyphs();
 
     // Load persistent data from flash
     load_cart_data();
@@ -0,0 +1,211 @@
+/*
+ * Hyperspace Matrix Expressions (C++17)
+ * constexpr Vec3 / Mat34 math over fix16_t for hyperspace_game.h
+ *
+ * Used when the game core is compiled as C++ (CXX_MATH build option,
+ * HYPERSPACE_CXX_MATH). A matrix is an expression whose entries are read
+ * with at<row, col>(); rotations and translations report their structural
+ * entries as the types Zero and One, so products with them fold away at
+ * compile time, and a chain like translate(...) * rotx(...) * dense(m) is
+ * evaluated entry by entry into its destination with no Mat34 in between.
+ *
+ * Every product is rounded on its own, exactly like fix16_mul() in
+ * mat_mul() / mat_mul_vec() (and multiplying by 0 or fix16_one is exact),
+ * so the results match the C helpers bit for bit.
+ *
+ * Works on any matrix type with fix16_t m[12] (3x4, row major) and any
+ * vector type with fix16_t x, y, z.
+ */
+
+#ifndef HYPERSPACE_MATH_HPP
+#define HYPERSPACE_MATH_HPP
+
+#include <stdint.h>
+#include <type_traits>
+#include "libfixmath/fixmath.h"
+
+namespace fx {
+
+// =============================================================================
+// Scalars
+// =============================================================================
+
+// Entries known by type
+struct Zero {};
+struct One {};
+
+constexpr fix16_t value(fix16_t v) { return v; }
+constexpr fix16_t value(Zero) { return 0; }
+constexpr fix16_t value(One) { return fix16_one; }
+
+// fix16_mul() as built here (FIXMATH_NO_OVERFLOW, rounding)
+constexpr fix16_t mul(fix16_t a, fix16_t b) {
+    int64_t product = (int64_t)a * b;
+    if (product < 0) product--;
+    return (fix16_t)(product >> 16) + (fix16_t)((product & 0x8000) >> 15);
+}
+
+template <class T> constexpr Zero mul(Zero, T) { return {}; }
+template <class T> constexpr Zero mul(T, Zero) { return {}; }
+template <class T> constexpr T mul(One, T b) { return b; }
+template <class T> constexpr T mul(T a, One) { return a; }
+constexpr Zero mul(Zero, Zero) { return {}; }
+constexpr Zero mul(Zero, One) { return {}; }
+constexpr Zero mul(One, Zero) { return {}; }
+constexpr One mul(One, One) { return {}; }
+
+template <class A, class B> constexpr fix16_t add(A a, B b) { return value(a) + value(b); }
+template <class T> constexpr T add(Zero, T b) { return b; }
+template <class T> constexpr T add(T a, Zero) { return a; }
+constexpr Zero add(Zero, Zero) { return {}; }
+
+// =============================================================================
+// Matrix Expressions
+// =============================================================================
+
+struct MatExpr {};
+
+template <class T> constexpr bool is_mat = std::is_base_of<MatExpr, T>::value;
+
+// A stored matrix (any type with fix16_t m[12])
+template <class M> struct Dense : MatExpr {
+    const M& mat;
+    constexpr explicit Dense(const M& m) : mat(m) {}
+    template <int R, int C> constexpr fix16_t at() const { return mat.m[R * 4 + C]; }
+};
+
+template <class M> constexpr Dense<M> dense(const M& m) { return Dense<M>(m); }
+
+// mat_rotx() / mat_roty() / mat_rotz() from a precomputed sin and cos
+struct RotX : MatExpr {
+    fix16_t s, c;
+    template <int R, int C> constexpr auto at() const {
+        if constexpr (R == 0 && C == 0) return One{};
+        else if constexpr (R == 0 || C == 0 || C == 3) return Zero{};
+        else if constexpr (R == C) return c;
+        else if constexpr (R == 1) return (fix16_t)-s;
+        else return s;
+    }
+};
+
+struct RotY : MatExpr {
+    fix16_t s, c;
+    template <int R, int C> constexpr auto at() const {
+        if constexpr (R == 1 && C == 1) return One{};
+        else if constexpr (R == 1 || C == 1 || C == 3) return Zero{};
+        else if constexpr (R == C) return c;
+        else if constexpr (R == 0) return (fix16_t)-s;
+        else return s;
+    }
+};
+
+struct RotZ : MatExpr {
+    fix16_t s, c;
+    template <int R, int C> constexpr auto at() const {
+        if constexpr (R == 2 && C == 2) return One{};
+        else if constexpr (R == 2 || C == 2 || C == 3) return Zero{};
+        else if constexpr (R == C) return c;
+        else if constexpr (R == 0) return (fix16_t)-s;
+        else return s;
+    }
+};
+
+// Angles in turns, as the C helpers take them (PICO-8's sin is negated)
+inline void sincos_turns(fix16_t a, fix16_t* s, fix16_t* c) {
+    fix16_sincos(fix16_mul(a, F16(6.28318530718)), s, c);
+}
+
+inline RotX rotx(fix16_t a) { RotX r; sincos_turns(a, &r.s, &r.c); return r; }
+inline RotY roty(fix16_t a) { RotY r; sincos_turns(a, &r.s, &r.c); return r; }
+inline RotZ rotz(fix16_t a) { RotZ r; sincos_turns(a, &r.s, &r.c); return r; }
+
+// mat_translation(), with any component allowed to be Zero
+template <class X, class Y, class Z> struct Translate : MatExpr {
+    X x; Y y; Z z;
+    constexpr Translate(X x_, Y y_, Z z_) : x(x_), y(y_), z(z_) {}
+    template <int R, int C> constexpr auto at() const {
+        if constexpr (C == 3) {
+            if constexpr (R == 0) return x;
+            else if constexpr (R == 1) return y;
+            else return z;
+        } else if constexpr (R == C) {
+            return One{};
+        } else {
+            return Zero{};
+        }
+    }
+};
+
+template <class X, class Y, class Z>
+constexpr Translate<X, Y, Z> translate(X x, Y y, Z z) { return Translate<X, Y, Z>(x, y, z); }
+
+// mat_mul(): 3x4 matrices with an implied (0, 0, 0, 1) bottom row
+template <class A, class B> struct Product : MatExpr {
+    A a; B b;
+    constexpr Product(const A& a_, const B& b_) : a(a_), b(b_) {}
+    template <int R, int C> constexpr auto at() const {
+        auto sum = add(add(mul(a.template at<R, 0>(), b.template at<0, C>()),
+                           mul(a.template at<R, 1>(), b.template at<1, C>())),
+                       mul(a.template at<R, 2>(), b.template at<2, C>()));
+        if constexpr (C == 3) return add(sum, a.template at<R, 3>());
+        else return sum;
+    }
+};
+
+template <class A, class B, class = std::enable_if_t<is_mat<A> && is_mat<B>>>
+constexpr Product<A, B> operator*(const A& a, const B& b) { return Product<A, B>(a, b); }
+
+// mat_transpose_rot(): rotation part transposed, translation column kept
+template <class A> struct TransposeRot : MatExpr {
+    A a;
+    constexpr explicit TransposeRot(const A& a_) : a(a_) {}
+    template <int R, int C> constexpr auto at() const {
+        if constexpr (C == 3) return a.template at<R, 3>();
+        else return a.template at<C, R>();
+    }
+};
+
+template <class A> constexpr TransposeRot<A> transpose_rot(const A& a) { return TransposeRot<A>(a); }
+
+// Evaluate every entry; out may appear in the expression
+template <class M, class E> constexpr void store(M& out, const E& e) {
+    const fix16_t r[12] = {
+        value(e.template at<0, 0>()), value(e.template at<0, 1>()), value(e.template at<0, 2>()), value(e.template at<0, 3>()),
+        value(e.template at<1, 0>()), value(e.template at<1, 1>()), value(e.template at<1, 2>()), value(e.template at<1, 3>()),
+        value(e.template at<2, 0>()), value(e.template at<2, 1>()), value(e.template at<2, 2>()), value(e.template at<2, 3>()),
+    };
+    for (int i = 0; i < 12; i++) out.m[i] = r[i];
+}
+
+// =============================================================================
+// Vectors
+// =============================================================================
+
+// Vector with components known by type, e.g. vec(Zero{}, Zero{}, -fix16_one)
+template <class X, class Y, class Z> struct Vec {
+    X x; Y y; Z z;
+};
+
+template <class X, class Y, class Z> constexpr Vec<X, Y, Z> vec(X x, Y y, Z z) { return {x, y, z}; }
+
+template <int R, class E, class V> constexpr auto row_dot(const E& e, const V& v) {
+    return add(add(mul(v.x, e.template at<R, 0>()), mul(v.y, e.template at<R, 1>())), mul(v.z, e.template at<R, 2>()));
+}
+
+// mat_mul_vec(): rotation only
+template <class W, class E, class V> constexpr void store_rot(W& out, const E& e, const V& v) {
+    fix16_t x = value(row_dot<0>(e, v)), y = value(row_dot<1>(e, v)), z = value(row_dot<2>(e, v));
+    out.x = x; out.y = y; out.z = z;
+}
+
+// mat_mul_pos(): rotation and translation
+template <class W, class E, class V> constexpr void store_pos(W& out, const E& e, const V& v) {
+    fix16_t x = value(add(row_dot<0>(e, v), e.template at<0, 3>()));
+    fix16_t y = value(add(row_dot<1>(e, v), e.template at<1, 3>()));
+    fix16_t z = value(add(row_dot<2>(e, v), e.template at<2, 3>()));
+    out.x = x; out.y = y; out.z = z;
+}
+
+} // namespace fx
+
+#endif // HYPERSPACE_MATH_HPP
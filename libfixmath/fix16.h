@@ -117,6 +117,17 @@ extern fix16_t fix16_mul(fix16_t inArg0, fix16_t inArg1) FIXMATH_FUNC_ATTRS;
 */
 extern fix16_t fix16_div(fix16_t inArg0, fix16_t inArg1) FIXMATH_FUNC_ATTRS;
 
+/*! Divides the first given fix16_t by the second using a table-seeded
+ *  Newton-Raphson reciprocal (multiplies only). Within 1 LSB of the exact
+ *  quotient for |result| < 256, within 3 LSB otherwise; saturates on
+ *  overflow. See fix16_recip.c.
+*/
+extern fix16_t fix16_div_fast(fix16_t inArg0, fix16_t inArg1) FIXMATH_FUNC_ATTRS;
+
+/*! Returns 1 / inValue with the accuracy of fix16_div_fast.
+*/
+extern fix16_t fix16_recip(fix16_t inValue) FIXMATH_FUNC_ATTRS;
+
 #ifndef FIXMATH_NO_OVERFLOW
 /*! Performs a saturated multiplication (overflow-protected) of the two given fix16_t's and returns the result.
 */
@@ -153,6 +164,12 @@ extern fix16_t fix16_sin(fix16_t inAngle) FIXMATH_FUNC_ATTRS;
 */
 extern fix16_t fix16_cos(fix16_t inAngle) FIXMATH_FUNC_ATTRS;
 
+/*! Returns the sine and cosine of the given fix16_t. With
+    FIXMATH_SIN_QUARTER_WAVE both come from one angle reduction and table
+    lookup; otherwise it is fix16_sin() and fix16_cos().
+*/
+extern void fix16_sincos(fix16_t inAngle, fix16_t *outSin, fix16_t *outCos);
+
 /*! Returns the tangent of the given fix16_t.
 */
 extern fix16_t fix16_tan(fix16_t inAngle) FIXMATH_FUNC_ATTRS;
@@ -1,14 +1,18 @@
 #include <limits.h>
 #include "fix16.h"
 
-#if defined(FIXMATH_SIN_LUT)
+#if defined(FIXMATH_SIN_QUARTER_WAVE)
+#include "fix16_trig_sin_quarter.h"
+#elif defined(FIXMATH_SIN_LUT)
 #include "fix16_trig_sin_lut.h"
 #elif !defined(FIXMATH_NO_CACHE)
 static fix16_t _fix16_sin_cache_index[4096]  = { 0 };
 static fix16_t _fix16_sin_cache_value[4096]  = { 0 };
 #endif
 
-#ifndef FIXMATH_NO_CACHE
+/* The quarter-wave backend is the small-RAM one: no atan cache either */
+#if !defined(FIXMATH_NO_CACHE) && !defined(FIXMATH_SIN_QUARTER_WAVE)
+#define FIXMATH_ATAN_CACHE
 static fix16_t _fix16_atan_cache_index[2][4096] = { { 0 }, { 0 } };
 static fix16_t _fix16_atan_cache_value[4096] = { 0 };
 #endif
@@ -44,6 +48,67 @@ fix16_t fix16_sin_parabola(fix16_t inAngle)
 	return retval;
 }
 
+#ifdef FIXMATH_SIN_QUARTER_WAVE
+/* Angle to a 32-bit fraction of a full turn, inAngle * 2^16 / (2 pi), so any
+ * angle wraps without a modulo. The top two bits select the quadrant.
+ */
+static inline uint32_t _fix16_turn(fix16_t inAngle)
+{
+	return (uint32_t)(((int64_t)inAngle * 683565276) >> 16);
+}
+
+static inline fix16_t _fix16_sin_quarter_entry(uint32_t i)
+{
+	uint32_t v = _fix16_sin_quarter[i];
+	return (fix16_t)(v + (v >> 15));
+}
+
+/* sin over the first quadrant, pos in [0, 2^30] */
+static inline fix16_t _fix16_sin_quarter_lerp(uint32_t pos)
+{
+	uint32_t i = pos >> (30 - _FIX16_SIN_QUARTER_BITS);
+	int32_t frac = (pos >> (14 - _FIX16_SIN_QUARTER_BITS)) & 0xFFFF;
+	fix16_t a = _fix16_sin_quarter_entry(i);
+	fix16_t b = _fix16_sin_quarter_entry(i + 1);
+	return a + (((b - a) * frac + 0x8000) >> 16);
+}
+
+static inline fix16_t _fix16_sin_turn(uint32_t turn)
+{
+	/* The second and fourth quadrants mirror the first, the last two negate it */
+	uint32_t pos = turn & 0x3FFFFFFF;
+	if(turn & 0x40000000)
+		pos = 0x40000000 - pos;
+	fix16_t out = _fix16_sin_quarter_lerp(pos);
+	return (turn & 0x80000000) ? -out : out;
+}
+
+fix16_t fix16_sin(fix16_t inAngle)
+{
+	return _fix16_sin_turn(_fix16_turn(inAngle));
+}
+
+fix16_t fix16_cos(fix16_t inAngle)
+{
+	return _fix16_sin_turn(_fix16_turn(inAngle) + 0x40000000);
+}
+
+void fix16_sincos(fix16_t inAngle, fix16_t *outSin, fix16_t *outCos)
+{
+	/* One reduction and table position for both: within a quadrant one of
+	   them reads the table forwards, the other backwards */
+	uint32_t turn = _fix16_turn(inAngle);
+	uint32_t pos = turn & 0x3FFFFFFF;
+	fix16_t fwd = _fix16_sin_quarter_lerp(pos);
+	fix16_t rev = _fix16_sin_quarter_lerp(0x40000000 - pos);
+	switch(turn >> 30) {
+	case 0:  *outSin = fwd;  *outCos = rev;  break;
+	case 1:  *outSin = rev;  *outCos = -fwd; break;
+	case 2:  *outSin = -fwd; *outCos = -rev; break;
+	default: *outSin = -rev; *outCos = fwd;  break;
+	}
+}
+#else
 fix16_t fix16_sin(fix16_t inAngle)
 {
 	fix16_t tempAngle = inAngle % (fix16_pi << 1);
@@ -111,6 +176,13 @@ fix16_t fix16_cos(fix16_t inAngle)
 	return fix16_sin(inAngle + (fix16_pi >> 1));
 }
 
+void fix16_sincos(fix16_t inAngle, fix16_t *outSin, fix16_t *outCos)
+{
+	*outSin = fix16_sin(inAngle);
+	*outCos = fix16_cos(inAngle);
+}
+#endif
+
 fix16_t fix16_tan(fix16_t inAngle)
 {
 	#ifndef FIXMATH_NO_OVERFLOW
@@ -142,7 +214,7 @@ fix16_t fix16_atan2(fix16_t inY , fix16_t inX)
 {
 	fix16_t abs_inY, mask, angle, r, r_3;
 
-	#ifndef FIXMATH_NO_CACHE
+	#ifdef FIXMATH_ATAN_CACHE
 	uintptr_t hash = (inX ^ inY);
 	hash ^= hash >> 20;
 	hash &= 0x0FFF;
@@ -171,7 +243,7 @@ fix16_t fix16_atan2(fix16_t inY , fix16_t inX)
 		angle = -angle;
 	}
 
-	#ifndef FIXMATH_NO_CACHE
+	#ifdef FIXMATH_ATAN_CACHE
 	_fix16_atan_cache_index[0][hash] = inX;
 	_fix16_atan_cache_index[1][hash] = inY;
 	_fix16_atan_cache_value[hash] = angle;
@@ -0,0 +1,93 @@
+#ifndef __fix16_trig_sin_quarter_h__
+#define __fix16_trig_sin_quarter_h__
+
+/* Quarter sine wave for FIXMATH_SIN_QUARTER_WAVE:
+ * round(sin(k * pi/2 / 512) * 65536) for k = 0..512, plus entry 513 mirroring
+ * entry 511 so that interpolating at exactly pi/2 stays in bounds.
+ *
+ * Values of 0.5 and above are stored minus one, so that 1.0 (65536) fits in
+ * 16 bits. fix16_trig.c decodes an entry v as v + (v >> 15); no entry is
+ * exactly 32768, so this is lossless. Regenerate with:
+ *
+ *   v = [round(math.sin(k * math.pi / 1024) * 65536) for k in range(514)]
+ *   table = [x - 1 if x > 32768 else x for x in v]
+ *
+ * Define FIXMATH_SIN_TABLE_SECTION to place the table in a RAM section of
+ * its own (e.g. ".scratch_y.fix16_sin" on the RP2350); otherwise it is
+ * ordinary const data.
+ */
+
+#define _FIX16_SIN_QUARTER_BITS 9
+static const uint16_t _fix16_sin_quarter[(1 << _FIX16_SIN_QUARTER_BITS) + 2]
+#ifdef FIXMATH_SIN_TABLE_SECTION
+	__attribute__((section(FIXMATH_SIN_TABLE_SECTION), aligned(4)))
+#endif
+	= {
+	0, 201, 402, 603, 804, 1005, 1206, 1407,
+	1608, 1809, 2010, 2211, 2412, 2613, 2814, 3015,
+	3216, 3417, 3617, 3818, 4019, 4219, 4420, 4621,
+	4821, 5022, 5222, 5422, 5623, 5823, 6023, 6224,
+	6424, 6624, 6824, 7024, 7224, 7423, 7623, 7823,
+	8022, 8222, 8421, 8621, 8820, 9019, 9218, 9417,
+	9616, 9815, 10014, 10212, 10411, 10609, 10808, 11006,
+	11204, 11402, 11600, 11798, 11996, 12193, 12391, 12588,
+	12785, 12983, 13180, 13376, 13573, 13770, 13966, 14163,
+	14359, 14555, 14751, 14947, 15143, 15338, 15534, 15729,
+	15924, 16119, 16314, 16508, 16703, 16897, 17091, 17285,
+	17479, 17673, 17867, 18060, 18253, 18446, 18639, 18832,
+	19024, 19216, 19409, 19600, 19792, 19984, 20175, 20366,
+	20557, 20748, 20939, 21129, 21320, 21510, 21699, 21889,
+	22078, 22268, 22457, 22645, 22834, 23022, 23210, 23398,
+	23586, 23774, 23961, 24148, 24335, 24521, 24708, 24894,
+	25080, 25265, 25451, 25636, 25821, 26005, 26190, 26374,
+	26558, 26742, 26925, 27108, 27291, 27474, 27656, 27838,
+	28020, 28202, 28383, 28564, 28745, 28926, 29106, 29286,
+	29466, 29645, 29824, 30003, 30182, 30360, 30538, 30716,
+	30893, 31071, 31248, 31424, 31600, 31776, 31952, 32127,
+	32303, 32477, 32652, 32825, 32999, 33172, 33346, 33519,
+	33691, 33864, 34036, 34207, 34379, 34550, 34720, 34891,
+	35061, 35230, 35400, 35569, 35737, 35906, 36074, 36242,
+	36409, 36576, 36743, 36909, 37075, 37240, 37406, 37571,
+	37735, 37899, 38063, 38227, 38390, 38553, 38715, 38877,
+	39039, 39200, 39361, 39522, 39682, 39842, 40001, 40160,
+	40319, 40477, 40635, 40793, 40950, 41107, 41263, 41419,
+	41575, 41730, 41885, 42039, 42193, 42347, 42500, 42653,
+	42805, 42957, 43109, 43260, 43411, 43561, 43712, 43861,
+	44010, 44159, 44307, 44455, 44603, 44750, 44897, 45043,
+	45189, 45334, 45479, 45624, 45768, 45911, 46055, 46198,
+	46340, 46482, 46623, 46764, 46905, 47045, 47185, 47324,
+	47463, 47602, 47740, 47877, 48014, 48151, 48287, 48423,
+	48558, 48693, 48827, 48961, 49094, 49227, 49360, 49492,
+	49623, 49755, 49885, 50015, 50145, 50274, 50403, 50531,
+	50659, 50786, 50913, 51040, 51165, 51291, 51416, 51540,
+	51664, 51788, 51910, 52033, 52155, 52276, 52397, 52518,
+	52638, 52758, 52877, 52995, 53113, 53231, 53348, 53464,
+	53580, 53696, 53811, 53925, 54039, 54153, 54266, 54378,
+	54490, 54602, 54713, 54823, 54933, 55042, 55151, 55259,
+	55367, 55475, 55581, 55688, 55793, 55899, 56003, 56107,
+	56211, 56314, 56417, 56519, 56620, 56721, 56822, 56922,
+	57021, 57120, 57218, 57316, 57413, 57510, 57606, 57702,
+	57797, 57891, 57985, 58078, 58171, 58264, 58355, 58447,
+	58537, 58627, 58717, 58806, 58895, 58982, 59070, 59157,
+	59243, 59329, 59414, 59498, 59582, 59666, 59749, 59831,
+	59913, 59994, 60074, 60155, 60234, 60313, 60391, 60469,
+	60546, 60623, 60699, 60775, 60850, 60924, 60998, 61071,
+	61144, 61216, 61287, 61358, 61428, 61498, 61567, 61636,
+	61704, 61771, 61838, 61905, 61970, 62035, 62100, 62164,
+	62227, 62290, 62352, 62414, 62475, 62535, 62595, 62654,
+	62713, 62771, 62829, 62885, 62942, 62997, 63053, 63107,
+	63161, 63214, 63267, 63319, 63371, 63422, 63472, 63522,
+	63571, 63620, 63667, 63715, 63762, 63808, 63853, 63898,
+	63943, 63986, 64030, 64072, 64114, 64155, 64196, 64236,
+	64276, 64315, 64353, 64391, 64428, 64464, 64500, 64535,
+	64570, 64604, 64638, 64671, 64703, 64734, 64765, 64796,
+	64826, 64855, 64883, 64911, 64939, 64966, 64992, 65017,
+	65042, 65066, 65090, 65113, 65136, 65158, 65179, 65199,
+	65219, 65239, 65258, 65276, 65293, 65310, 65327, 65342,
+	65357, 65372, 65386, 65399, 65412, 65424, 65435, 65446,
+	65456, 65466, 65475, 65483, 65491, 65498, 65504, 65510,
+	65515, 65520, 65524, 65527, 65530, 65532, 65534, 65535,
+	65535, 65535,
+};
+
+#endif
@@ -16,13 +16,20 @@
 #include "hardware/flash.h"
 #include "hardware/sync.h"
 #include "hardware/gpio.h"
+#include "pico/flash.h"
+#include "hardware/vreg.h"
+#ifdef THUMBYCOLOR_DUAL_CORE
+#include "pico/multicore.h"
+#include "pico/util/queue.h"
+#endif
 #include "thumbycolor_hw.h"
+#include "thumbycolor_profiler.h"
+#include "thumbycolor_save.h"
+#ifdef THUMBYCOLOR_REPLAY
+#include "thumbycolor_replay.h"
+#endif
 #include "libfixmath/fixmath.h"
 
-// Flash storage for persistent data
-#define FLASH_TARGET_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
-#define FLASH_MAGIC 0x48595045  // "HYPE"
-
 // Screen dimensions (ThumbyColor: 128x128, same as PICO-8!)
 #define SCREEN_WIDTH  128
 #define SCREEN_HEIGHT 128
@@ -65,8 +72,8 @@
 // STD_SWAP shows BRG (R→B, G→R, B→G), so input must be (b, r, g)
 #define RGB565_STD_SWAP_FIXED(r, g, b) RGB565_STD_SWAP(b, r, g)
 
-// PICO-8 16-color palette in RGB565
-static const uint16_t PICO8_PALETTE[16] = {
+// PICO-8 16-color palette in RGB565 (read per pixel by the display IRQ)
+static const uint16_t HOT_SCRATCH_X("pico8_palette") PICO8_PALETTE[16] = {
     RGB565(0x00, 0x00, 0x00), //  0: black        #000000
     RGB565(0x1D, 0x2B, 0x53), //  1: dark blue    #1D2B53
     RGB565(0x7E, 0x25, 0x53), //  2: dark purple  #7E2553
@@ -85,27 +92,19 @@ static const uint16_t PICO8_PALETTE[16] = {
     RGB565(0xFF, 0xCC, 0xAA), // 15: peach        #FFCCAA
 };
 
-// Screen buffer (8-bit palette indices)
-static uint8_t screen[SCREEN_HEIGHT][SCREEN_WIDTH];
-
-// RGB565 framebuffer for display
-static uint16_t framebuffer[SCREEN_HEIGHT * SCREEN_WIDTH];
-
-// Sprite sheet (128x128 pixels, 4-bit palette)
-static uint8_t spritesheet[128][128];
-
-// Map memory (for mesh data)
-static uint8_t map_memory[0x1000];
-
-// Palette mapping for pal()
-static uint8_t palette_map[16];
+#ifdef HYPERSPACE_SCREEN_4BPP
+// Both pixels of a packed screen byte in RGB565 (thumbycolor_build_pair_lut()),
+// read for every byte sent by the display IRQ
+static uint32_t HOT_SCRATCH_X("pico8_pairs") pico8_pairs[256];
+#endif
 
-// Drawing color
-static uint8_t draw_color = 7;
-
-// Clip region
-static int clip_x1 = 0, clip_y1 = 0;
-static int clip_x2 = SCREEN_WIDTH - 1, clip_y2 = SCREEN_HEIGHT - 1;
+// Number of screen buffers
+// Dual-core mode: core 0 draws frame N+1 while core 1 presents frame N
+#ifdef THUMBYCOLOR_DUAL_CORE
+#define SCREEN_BUFFER_COUNT 2
+#else
+#define SCREEN_BUFFER_COUNT 1
+#endif
 
 // Random seed
 static uint32_t rnd_state = 1;
@@ -115,41 +114,32 @@ static bool btn_state[6] = {false};
 static bool btn_prev[6] = {false};
 static bool btn_menu_held = false;  // Menu button for palette display
 static bool btn_bumper_l_held = false;  // L button for color bar test
+static bool btn_bumper_r_held = false;  // R button for profiler overlay
 
 // Cart data (persistent storage)
 static int32_t cart_data[64] = {0};
 static bool cart_data_dirty = false;
 
-// Flash storage structure
-typedef struct {
-    uint32_t magic;
-    int32_t data[64];
-} FlashSaveData;
-
 static void load_cart_data(void) {
-    const FlashSaveData* flash_data = (const FlashSaveData*)(XIP_BASE + FLASH_TARGET_OFFSET);
-    if (flash_data->magic == FLASH_MAGIC) {
-        memcpy(cart_data, flash_data->data, sizeof(cart_data));
-    }
+    save_journal_load(cart_data);
+#ifdef THUMBYCOLOR_REPLAY
+    // Options and best score are part of the recorded session
+    replay_cart_data(cart_data, sizeof(cart_data));
+#endif
 }
 
 static void save_cart_data(void) {
     if (!cart_data_dirty) return;
+    cart_data_dirty = false;
 
-    FlashSaveData save_data;
-    save_data.magic = FLASH_MAGIC;
-    memcpy(save_data.data, cart_data, sizeof(cart_data));
-
-    uint8_t buffer[512] __attribute__((aligned(4)));
-    memset(buffer, 0xFF, sizeof(buffer));
-    memcpy(buffer, &save_data, sizeof(save_data));
-
-    uint32_t ints = save_and_disable_interrupts();
-    flash_range_erase(FLASH_TARGET_OFFSET, FLASH_SECTOR_SIZE);
-    flash_range_program(FLASH_TARGET_OFFSET, buffer, sizeof(buffer));
-    restore_interrupts(ints);
+#ifdef THUMBYCOLOR_REPLAY
+    // Replays must not overwrite the real save data
+    if (replay_get_mode() == REPLAY_PLAYING) return;
+#endif
 
-    cart_data_dirty = false;
+    // Only queues the changed entries: the main loop writes them to the
+    // save journal between frames (save_journal_service())
+    save_journal_write(cart_data);
 }
 
 // Fixed-point constants
@@ -161,114 +151,10 @@ static void save_cart_data(void) {
 #define FIX_PROJ_CONST F16(-80.0)    // Projection constant for 128px
 
 // =============================================================================
-// PICO-8 API Implementation
+// PICO-8 API Implementation (shared with the host benchmark)
 // =============================================================================
 
-static void cls(void) {
-    memset(screen, 0, sizeof(screen));
-}
-
-static void pset(int x, int y, int c) {
-    if (x >= clip_x1 && x <= clip_x2 && y >= clip_y1 && y <= clip_y2 &&
-        x >= 0 && x < SCREEN_WIDTH && y >= 0 && y < SCREEN_HEIGHT) {
-        screen[y][x] = palette_map[c & 15];
-    }
-}
-
-// Fast pset - uses palette mapping for animation
-#define PSET_FAST(x, y, c) (screen[(y)][(x)] = palette_map[(c) & 15])
-
-static uint8_t pget(int x, int y) {
-    if (x >= 0 && x < SCREEN_WIDTH && y >= 0 && y < SCREEN_HEIGHT) {
-        return screen[y][x];
-    }
-    return 0;
-}
-
-static uint8_t sget(int x, int y) {
-    if (x >= 0 && x < 128 && y >= 0 && y < 128) {
-        return spritesheet[y][x];
-    }
-    return 0;
-}
-
-// Fast texture fetch
-#define SGET_FAST(x, y) (spritesheet[(y)][(x)])
-
-static void line(int x0, int y0, int x1, int y1, int c) {
-    int dx = abs(x1 - x0);
-    int dy = abs(y1 - y0);
-    int sx = x0 < x1 ? 1 : -1;
-    int sy = y0 < y1 ? 1 : -1;
-    int err = dx - dy;
-
-    while (1) {
-        pset(x0, y0, c);
-        if (x0 == x1 && y0 == y1) break;
-        int e2 = 2 * err;
-        if (e2 > -dy) { err -= dy; x0 += sx; }
-        if (e2 < dx) { err += dx; y0 += sy; }
-    }
-}
-
-static void rectfill(int x0, int y0, int x1, int y1, int c) {
-    if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
-    if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
-    for (int y = y0; y <= y1; y++) {
-        for (int x = x0; x <= x1; x++) {
-            pset(x, y, c);
-        }
-    }
-}
-
-static void circfill(int cx, int cy, int r, int c) {
-    for (int y = -r; y <= r; y++) {
-        for (int x = -r; x <= r; x++) {
-            if (x*x + y*y <= r*r) {
-                pset(cx + x, cy + y, c);
-            }
-        }
-    }
-}
-
-static void spr(int n, int x, int y, int w, int h) {
-    int sx = (n & 15) * 8;
-    int sy = (n / 16) * 8;
-    for (int py = 0; py < h * 8; py++) {
-        for (int px = 0; px < w * 8; px++) {
-            uint8_t c = sget(sx + px, sy + py);
-            if (c != 0) {
-                pset(x + px, y + py, palette_map[c]);
-            }
-        }
-    }
-}
-
-static void pal_reset(void) {
-    for (int i = 0; i < 16; i++) palette_map[i] = i;
-}
-
-static void pal(int c0, int c1) {
-    palette_map[c0 & 15] = c1 & 15;
-}
-
-static void clip_set(int x, int y, int w, int h) {
-    clip_x1 = x;
-    clip_y1 = y;
-    clip_x2 = x + w - 1;
-    clip_y2 = y + h - 1;
-}
-
-static void clip_reset(void) {
-    clip_x1 = 0;
-    clip_y1 = 0;
-    clip_x2 = SCREEN_WIDTH - 1;
-    clip_y2 = SCREEN_HEIGHT - 1;
-}
-
-static void color(int c) {
-    draw_color = c & 15;
-}
+#include "pico8_api.h"
 
 // =============================================================================
 // Platform-specific audio implementation
@@ -276,6 +162,9 @@ static void color(int c) {
 
 #define PLATFORM_SFX  // Enable platform-specific sfx() implementation
 
+// Setup errors in the game core halt with the message on stdio
+#define GAME_FATAL(...) panic(__VA_ARGS__)
+
 void platform_sfx(int n, int channel) {
     thumbycolor_sfx(n, channel);
 }
@@ -293,6 +182,9 @@ void platform_sfx(int n, int channel) {
 
 static void update_buttons(void) {
     uint32_t buttons = thumbycolor_get_buttons();
+#ifdef THUMBYCOLOR_REPLAY
+    buttons = replay_buttons(buttons);
+#endif
 
     for (int i = 0; i < 6; i++) {
         btn_prev[i] = btn_state[i];
@@ -310,8 +202,40 @@ static void update_buttons(void) {
 
     // L bumper for color bar test
     btn_bumper_l_held = (buttons & BUTTON_BUMPER_L) != 0;
+
+    // R bumper for profiler overlay
+    btn_bumper_r_held = (buttons & BUTTON_BUMPER_R) != 0;
 }
 
+#ifdef THUMBYCOLOR_PROFILER
+// =============================================================================
+// Profiler Overlay (hold R, numbers are from the previous frame)
+// =============================================================================
+
+static void draw_profiler_overlay(void) {
+    char buf[32];
+    int rows = PROF_NUM_PHASES + 3;
+    rectfill(0, 0, 75, rows * 6, 0);
+
+    snprintf(buf, sizeof(buf), "FRAME %5luUS", (unsigned long)profiler_frame_us());
+    print_str(buf, 1, 1, 7);
+    for (int i = 0; i < PROF_NUM_PHASES; i++) {
+        profiler_phase_t phase = (profiler_phase_t)i;
+        snprintf(buf, sizeof(buf), "%-6s%6luUS", profiler_phase_name(phase), (unsigned long)profiler_phase_us(phase));
+        print_str(buf, 1, 7 + i * 6, 6);
+    }
+
+    uint32_t submitted = profiler_count(PROF_TRIS_SUBMITTED);
+    uint32_t rasterized = profiler_count(PROF_TRIS_RASTERIZED);
+    int y = 7 + PROF_NUM_PHASES * 6;
+    snprintf(buf, sizeof(buf), "TRI %lu/%lu CUL %lu", (unsigned long)rasterized,
+             (unsigned long)submitted, (unsigned long)(submitted - rasterized));
+    print_str(buf, 1, y, 11);
+    snprintf(buf, sizeof(buf), "PIX %lu", (unsigned long)profiler_count(PROF_PIXELS));
+    print_str(buf, 1, y + 6, 11);
+}
+#endif
+
 // =============================================================================
 // Palette Display (for PICO-8 color comparison)
 // =============================================================================
@@ -321,6 +245,9 @@ static void draw_palette_display(void) {
     // Each cell is 32x32 pixels (128/4 = 32)
     const int cell_size = 32;
 
+    // Writes every pixel directly
+    mark_all_dirty();
+
     for (int i = 0; i < 16; i++) {
         int col = i % 4;
         int row = i / 4;
@@ -330,48 +257,54 @@ static void draw_palette_display(void) {
         // Fill rectangle with color i (bypass palette_map to show true colors)
         for (int y = y0; y < y0 + cell_size; y++) {
             for (int x = x0; x < x0 + cell_size; x++) {
-                screen[y][x] = i;
+                screen_put(screen[y], x, i);
             }
         }
 
         // Draw border (color 0 or 7 for contrast)
         int border_color = (i == 0 || i == 1 || i == 2 || i == 5) ? 7 : 0;
         for (int x = x0; x < x0 + cell_size; x++) {
-            screen[y0][x] = border_color;
-            screen[y0 + cell_size - 1][x] = border_color;
+            screen_put(screen[y0], x, border_color);
+            screen_put(screen[y0 + cell_size - 1], x, border_color);
         }
         for (int y = y0; y < y0 + cell_size; y++) {
-            screen[y][x0] = border_color;
-            screen[y][x0 + cell_size - 1] = border_color;
+            screen_put(screen[y], x0, border_color);
+            screen_put(screen[y], x0 + cell_size - 1, border_color);
         }
     }
 }
 
 // =============================================================================
-// Color Bar Test (direct RGB565 output)
+// Color Bar Test (custom palette output)
 // =============================================================================
 
+// Test RGB333 macro with 100% and 50% colors
+// Drawn as indices into its own palette so it goes through the same
+// streamed presentation path as the game
+static const uint16_t COLOR_BAR_PALETTE[16] = {
+    // 100% colors
+    RGB565(0xFF, 0x00, 0x00),  // 0: Red
+    RGB565(0x00, 0xFF, 0x00),  // 1: Green
+    RGB565(0x00, 0x00, 0xFF),  // 2: Blue
+    RGB565(0xFF, 0xFF, 0xFF),  // 3: White
+    // 50% colors
+    RGB565(0x80, 0x00, 0x00),  // 4: 50% Red
+    RGB565(0x00, 0x80, 0x00),  // 5: 50% Green
+    RGB565(0x00, 0x00, 0x80),  // 6: 50% Blue
+    RGB565(0x80, 0x80, 0x80),  // 7: 50% Gray
+    0x0E39,                    // 8: Gray divider
+};
+
+#ifdef HYPERSPACE_SCREEN_4BPP
+static uint32_t color_bar_pairs[256];
+#endif
+
 static void draw_color_bars_test(void) {
-    // Test RGB333 macro with 100% and 50% colors
     // Top: 100%, Bottom: 50%
     // Columns: Red, Green, Blue, White
     const int half_height = SCREEN_HEIGHT / 2;
 
-    // 100% colors
-    const uint16_t full[4] = {
-        RGB565(0xFF, 0x00, 0x00),  // Red
-        RGB565(0x00, 0xFF, 0x00),  // Green
-        RGB565(0x00, 0x00, 0xFF),  // Blue
-        RGB565(0xFF, 0xFF, 0xFF),  // White
-    };
-
-    // 50% colors
-    const uint16_t half[4] = {
-        RGB565(0x80, 0x00, 0x00),  // 50% Red
-        RGB565(0x00, 0x80, 0x00),  // 50% Green
-        RGB565(0x00, 0x00, 0x80),  // 50% Blue
-        RGB565(0x80, 0x80, 0x80),  // 50% Gray
-    };
+    mark_all_dirty();
 
     for (int y = 0; y < SCREEN_HEIGHT; y++) {
         for (int x = 0; x < SCREEN_WIDTH; x++) {
@@ -379,28 +312,373 @@ static void draw_color_bars_test(void) {
             if (col > 3) col = 3;
 
             if (y < half_height) {
-                framebuffer[y * SCREEN_WIDTH + x] = full[col];
+                screen_put(screen[y], x, col);
             } else if (y == half_height) {
-                framebuffer[y * SCREEN_WIDTH + x] = 0x0E39;  // Gray divider
+                screen_put(screen[y], x, 8);
             } else {
-                framebuffer[y * SCREEN_WIDTH + x] = half[col];
+                screen_put(screen[y], x, 4 + col);
             }
         }
     }
 }
 
 // =============================================================================
-// Screen Buffer to Framebuffer Conversion
+// Frame Presentation
 // =============================================================================
 
-static void render_to_framebuffer(void) {
+// What the presenter should do with a finished screen buffer
+#define PRESENT_GAME     0  // Send with PICO-8 palette (game frame)
+#define PRESENT_PALETTE  1  // Send with PICO-8 palette
+#define PRESENT_BARS     2  // Send with color bar test palette
+
+// -----------------------------------------------------------------------------
+// Partial updates
+//
+// The panel keeps the last presented frame. A row has to be resent only if
+// it was drawn in this frame or the previous one (every frame starts with
+// cls()), and only if its contents actually changed. Changed rows are merged
+// into bands, each sent as one GC9107 window. A full refresh is forced when
+// the palette changes and every FULL_REFRESH_INTERVAL frames, which also
+// bounds the damage of a missed span or a row hash collision.
+// -----------------------------------------------------------------------------
+
+#define FULL_REFRESH_INTERVAL 120
+
+// Presenter state: describes what the panel currently shows
+static DirtySpans presented_spans;
+static uint32_t presented_hash[SCREEN_HEIGHT];
+static const uint16_t *presented_palette = NULL;
+static int frames_since_full_refresh = 0;
+
+static uint32_t row_hash(const uint8_t *row) {
+    const uint32_t *words = (const uint32_t *)row;
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < SCREEN_ROW_BYTES / 4; i++) {
+        // Multiply only carries upwards, so fold the high bits back down
+        h = (h ^ words[i]) * 0x9E3779B1u;
+        h ^= h >> 15;
+    }
+    return h;
+}
+
+static int build_dirty_rects(int index, const uint16_t *palette, display_rect_t *rects) {
+    static const uint8_t zero_row[SCREEN_ROW_BYTES] __attribute__((aligned(4))) = {0};
+    const uint8_t (*src)[SCREEN_ROW_BYTES] = screen_buffers[index];
+    const DirtySpans *cur = &screen_dirty[index];
+    uint32_t zero_hash = row_hash(zero_row);
+
+    bool full = (palette != presented_palette) ||
+                (++frames_since_full_refresh >= FULL_REFRESH_INTERVAL);
+    if (full) frames_since_full_refresh = 0;
+    presented_palette = palette;
+
+    int count = 0;
+    display_rect_t *band = NULL;
+
     for (int y = 0; y < SCREEN_HEIGHT; y++) {
-        for (int x = 0; x < SCREEN_WIDTH; x++) {
-            framebuffer[y * SCREEN_WIDTH + x] = PICO8_PALETTE[screen[y][x] & 15];
+        int x0 = cur->x0[y] < presented_spans.x0[y] ? cur->x0[y] : presented_spans.x0[y];
+        int x1 = cur->x1[y] > presented_spans.x1[y] ? cur->x1[y] : presented_spans.x1[y];
+        bool send;
+
+        if (full) {
+            x0 = 0;
+            x1 = SCREEN_WIDTH - 1;
+            presented_hash[y] = row_hash(src[y]);
+            send = true;
+        } else if (x0 > x1) {
+            // Blank in both frames, so the panel row is blank too
+            presented_hash[y] = zero_hash;
+            send = false;
+        } else {
+            uint32_t h = row_hash(src[y]);
+            send = (h != presented_hash[y]);
+            presented_hash[y] = h;
+        }
+
+        if (!send) {
+            band = NULL;
+            continue;
+        }
+
+        if (band == NULL && count < DISPLAY_MAX_RECTS) {
+            band = &rects[count++];
+            band->x0 = x0;
+            band->x1 = x1;
+            band->y0 = y;
+        } else if (band == NULL) {
+            // Out of windows: grow the last band down to this row
+            band = &rects[count - 1];
+        }
+
+        if (x0 < band->x0) band->x0 = x0;
+        if (x1 > band->x1) band->x1 = x1;
+        band->y1 = y;
+    }
+
+    presented_spans = *cur;
+    return count;
+}
+
+// Presented frame rate: one game_update() per frame at 60 Hz, two at 30 Hz,
+// so the game runs at the same speed either way
+static int sim_steps = 1;
+
+static void present_frame(int index, int mode) {
+    const uint16_t *palette = (mode == PRESENT_BARS) ? COLOR_BAR_PALETTE : PICO8_PALETTE;
+
+    // Palette conversion is streamed a few lines at a time from the display
+    // IRQ, overlapping the SPI transfer; returns immediately
+    display_rect_t rects[DISPLAY_MAX_RECTS];
+    int num_rects = build_dirty_rects(index, palette, rects);
+#ifdef HYPERSPACE_SCREEN_4BPP
+    const uint32_t *pairs = (mode == PRESENT_BARS) ? color_bar_pairs : pico8_pairs;
+    thumbycolor_present_packed_rects(&screen_buffers[index][0][0], pairs, rects, num_rects);
+#else
+    thumbycolor_present_indexed_rects(&screen_buffers[index][0][0], palette, rects, num_rects);
+#endif
+}
+
+#ifdef THUMBYCOLOR_DUAL_CORE
+
+// Buffer handoff between the cores (one 32-bit word per message):
+//   present_queue, core 0 -> core 1: buffer index (bits 0-7) | present mode (bits 8-15)
+//   free_queue,    core 1 -> core 0: buffer index, once the screen buffer may be reused
+// The SIO FIFO is left to flash_safe_execute(): its lockout IRQ on core 1
+// drains the FIFO and drops every word that is not a lockout request.
+#define PRESENT_MSG(index, mode) ((uint32_t)(index) | ((uint32_t)(mode) << 8))
+
+static queue_t present_queue;
+static queue_t free_queue;
+static int back_buffer = 0;
+static int frames_in_flight = 0;
+
+static void present_queues_init(void) {
+    queue_init(&present_queue, sizeof(uint32_t), SCREEN_BUFFER_COUNT);
+    queue_init(&free_queue, sizeof(uint32_t), SCREEN_BUFFER_COUNT);
+}
+
+// Take back a buffer core 1 has finished with
+static void reclaim_buffer(void) {
+    uint32_t index;
+    queue_remove_blocking(&free_queue, &index);
+    frames_in_flight--;
+}
+
+static void core1_main(void) {
+    // Allow core 0 to park this core during flash writes (save journal)
+    flash_safe_execute_core_init();
+
+    while (1) {
+        uint32_t msg;
+        queue_remove_blocking(&present_queue, &msg);
+        uint32_t index = msg & 0xFF;
+        present_frame((int)index, (msg >> 8) & 0xFF);
+        // The screen buffer is read until the last chunk has been sent
+        thumbycolor_wait_present();
+        queue_add_blocking(&free_queue, &index);
+    }
+}
+
+static void submit_frame(int mode) {
+    PROF_BEGIN(PROF_PRESENT);
+    uint32_t msg = PRESENT_MSG(back_buffer, mode);
+    queue_add_blocking(&present_queue, &msg);
+    frames_in_flight++;
+    back_buffer ^= 1;
+    PROF_END(PROF_PRESENT);
+
+    // Block only when core 1 still owns the buffer we want to draw into next
+    if (frames_in_flight == SCREEN_BUFFER_COUNT) {
+        PROF_BEGIN(PROF_PRESENT_WAIT);
+        reclaim_buffer();
+        PROF_END(PROF_PRESENT_WAIT);
+    }
+    screen = screen_buffers[back_buffer];
+    dirty = &screen_dirty[back_buffer];
+}
+
+// Core 0 always draws into a buffer core 1 has already returned
+static void begin_draw(void) {
+}
+
+// Wait until core 1 has returned every buffer (display idle)
+static void flush_presentation(void) {
+    while (frames_in_flight > 0) reclaim_buffer();
+}
+
+#else
+
+static void submit_frame(int mode) {
+    PROF_BEGIN(PROF_PRESENT);
+    present_frame(0, mode);
+    PROF_END(PROF_PRESENT);
+}
+
+// The single screen buffer is streamed to the display after submit_frame(),
+// so drawing the next frame has to wait for the transfer to finish
+static void begin_draw(void) {
+    PROF_BEGIN(PROF_PRESENT_WAIT);
+    thumbycolor_wait_present();
+    PROF_END(PROF_PRESENT_WAIT);
+}
+
+static void flush_presentation(void) {
+    thumbycolor_wait_present();
+}
+
+#endif
+
+// =============================================================================
+// Adaptive Frame Rate
+// =============================================================================
+
+// The rate switch depends on wall-clock timing, which a replay can't
+// reproduce; replays always run at a fixed 60 Hz
+#if defined(THUMBYCOLOR_ADAPTIVE_FPS) && defined(THUMBYCOLOR_REPLAY)
+#undef THUMBYCOLOR_ADAPTIVE_FPS
+#endif
+
+#ifdef THUMBYCOLOR_ADAPTIVE_FPS
+
+// Drop to 30 Hz when too many 60 Hz deadlines are missed, go back once a
+// frame (minus its second update) would fit 60 Hz with headroom again
+#define PACE_MISS_WINDOW    16   // Recent 60 Hz frames considered
+#define PACE_MISS_LIMIT     4    // Misses in the window that trigger 30 Hz
+#define PACE_RECOVER_FRAMES 60   // Consecutive fitting 30 Hz frames before 60 Hz
+#define PACE_HEADROOM_US    (THUMBYCOLOR_FRAME_US_60HZ * 3 / 4)
+
+static uint32_t pace_miss_history = 0;  // One bit per frame, newest in bit 0
+static int pace_recover_count = 0;
+
+static void set_sim_steps(int steps) {
+    sim_steps = steps;
+    thumbycolor_set_frame_period(steps == 1 ? THUMBYCOLOR_FRAME_US_60HZ : THUMBYCOLOR_FRAME_US_30HZ);
+    pace_miss_history = 0;
+    pace_recover_count = 0;
+    printf("Frame rate: %d Hz\n", 60 / steps);
+}
+
+// slack_us: from thumbycolor_wait_vsync(), update_us: cost of one game_update()
+static void pace_frame(int32_t slack_us, uint32_t update_us) {
+    if (sim_steps == 1) {
+        pace_miss_history = (pace_miss_history << 1) | (slack_us < 0 ? 1u : 0u);
+        if (__builtin_popcount(pace_miss_history & ((1u << PACE_MISS_WINDOW) - 1)) >= PACE_MISS_LIMIT) {
+            set_sim_steps(2);
+        }
+    } else {
+        int32_t single_step_us = THUMBYCOLOR_FRAME_US_30HZ - slack_us - (int32_t)update_us;
+        if (single_step_us < PACE_HEADROOM_US) {
+            if (++pace_recover_count >= PACE_RECOVER_FRAMES) set_sim_steps(1);
+        } else {
+            pace_recover_count = 0;
         }
     }
 }
 
+#endif
+
+// =============================================================================
+// Clock Governor
+// =============================================================================
+
+// Clock changes shift the frame timing that replays are there to compare;
+// replays always run at the stock clock
+#if defined(THUMBYCOLOR_GOVERNOR) && defined(THUMBYCOLOR_REPLAY)
+#undef THUMBYCOLOR_GOVERNOR
+#endif
+
+#ifdef THUMBYCOLOR_GOVERNOR
+
+// System clock levels, slowest first. The SPI pixel clock is clk_sys over
+// an even divider, at most SPI_BAUDRATE_DATA. At 160 MHz, clk_sys / 2 is
+// exactly the 80 MHz pixel clock. Anything between 160 and 320 MHz has to
+// divide by 4 (200 MHz gives 50 MHz), and presentation would get slower
+// than at stock.
+typedef struct {
+    uint32_t sys_khz;
+    uint32_t vreg_voltage;
+} clock_level_t;
+
+static const clock_level_t clock_levels[] = {
+    {  96000, VREG_VOLTAGE_1_05 },  // SPI 48 MHz
+    { 150000, VREG_VOLTAGE_1_10 },  // Stock, SPI 75 MHz
+    { 160000, VREG_VOLTAGE_1_15 },  // SPI 80 MHz
+};
+#define CLOCK_LEVEL_STOCK 1
+
+// Levels a profile may use: battery underclocks light scenes (title,
+// test views), performance overclocks heavy waves
+#ifdef THUMBYCOLOR_GOVERNOR_BATTERY
+#define GOV_MIN_LEVEL 0
+#define GOV_MAX_LEVEL 1
+#else
+#define GOV_MIN_LEVEL 1
+#define GOV_MAX_LEVEL 2
+#endif
+
+#define GOV_WINDOW    32    // Frames averaged per decision
+#define GOV_UP_LOAD   230   // Busy share of the frame (/256) that steps up
+#define GOV_DOWN_LOAD 192   // Busy share the level below must stay under
+
+static int gov_level = CLOCK_LEVEL_STOCK;
+static uint32_t gov_busy_us = 0;
+static uint32_t gov_period_us = 0;
+static int gov_frames = 0;
+static bool gov_skip_frame = false;  // Frame stalled by a clock switch or flash write
+
+static void set_clock_level(int level) {
+    // The SPI divider changes with the clock: not under a transfer in flight
+    flush_presentation();
+    const clock_level_t *l = &clock_levels[level];
+    if (!thumbycolor_set_sys_clock(l->sys_khz, l->vreg_voltage)) {
+        printf("Clock: %lu kHz not available\n", (unsigned long)l->sys_khz);
+        return;
+    }
+    gov_level = level;
+    gov_skip_frame = true;
+#ifdef THUMBYCOLOR_PROFILER
+    profiler_clock_changed();
+#endif
+    printf("Clock: %lu MHz\n", (unsigned long)(l->sys_khz / 1000));
+}
+
+// slack_us: from thumbycolor_wait_vsync()
+static void govern_clock(int32_t slack_us) {
+    if (gov_skip_frame) {
+        gov_skip_frame = false;
+        return;
+    }
+
+    // A late frame steps up at once, before adaptive pacing drops to 30 Hz
+    if (slack_us < 0 && gov_level < GOV_MAX_LEVEL) {
+        gov_busy_us = gov_period_us = 0;
+        gov_frames = 0;
+        set_clock_level(gov_level + 1);
+        return;
+    }
+
+    int32_t period_us = sim_steps == 1 ? THUMBYCOLOR_FRAME_US_60HZ : THUMBYCOLOR_FRAME_US_30HZ;
+    gov_busy_us += (uint32_t)(period_us - slack_us);
+    gov_period_us += (uint32_t)period_us;
+    if (++gov_frames < GOV_WINDOW) return;
+
+    uint32_t load = (uint32_t)((uint64_t)gov_busy_us * 256 / gov_period_us);
+    gov_busy_us = gov_period_us = 0;
+    gov_frames = 0;
+
+    if (load > GOV_UP_LOAD && gov_level < GOV_MAX_LEVEL) {
+        set_clock_level(gov_level + 1);
+    } else if (gov_level > GOV_MIN_LEVEL) {
+        // Busy time scales (roughly) with the clock period: only step down
+        // when the frame would still fit with headroom
+        uint32_t lower_load = (uint32_t)((uint64_t)load * clock_levels[gov_level].sys_khz /
+                                         clock_levels[gov_level - 1].sys_khz);
+        if (lower_load < GOV_DOWN_LOAD) set_clock_level(gov_level - 1);
+    }
+}
+
+#endif
+
 // =============================================================================
 // Main Entry Point
 // =============================================================================
@@ -415,8 +693,17 @@ int main(void) {
     // Load sprite and map data (from hyperspace_data.h)
     load_embedded_data();
 
+#ifdef HYPERSPACE_SCREEN_4BPP
+    thumbycolor_build_pair_lut(PICO8_PALETTE, pico8_pairs);
+    thumbycolor_build_pair_lut(COLOR_BAR_PALETTE, color_bar_pairs);
+#endif
+
     // Initialize random seed
     rnd_state = thumbycolor_time_ms();
+#ifdef THUMBYCOLOR_REPLAY
+    // Record the seed, or replace it with the recorded one
+    replay_init(&rnd_state);
+#endif
 
     // Initialize game
     game_init();
@@ -424,6 +711,22 @@ int main(void) {
     // Turn off LED
     thumbycolor_set_led(0, 0, 0);
 
+#ifdef THUMBYCOLOR_PROFILER
+    profiler_init();
+#endif
+
+#ifdef THUMBYCOLOR_DUAL_CORE
+    // Core 1 takes over palette conversion and display DMA
+    present_queues_init();
+    multicore_launch_core1(core1_main);
+#endif
+
+#ifdef THUMBYCOLOR_REPLAY
+    int replay_prev_mode = cur_mode;
+#endif
+
+    uint32_t update_us = 0;
+
     // Main loop
     while (1) {
         // Update input
@@ -431,26 +734,80 @@ int main(void) {
 
         // Update and draw game (or show test patterns)
         if (btn_bumper_l_held) {
-            // Show color bar test when L is held (direct framebuffer)
+            // Show color bar test when L is held (custom palette)
+            begin_draw();
             draw_color_bars_test();
-            thumbycolor_update(framebuffer);
+            submit_frame(PRESENT_BARS);
         } else if (btn_menu_held) {
             // Show palette display when Menu is held
+            begin_draw();
             draw_palette_display();
-            render_to_framebuffer();
-            thumbycolor_update(framebuffer);
+            submit_frame(PRESENT_PALETTE);
         } else {
-            game_update();
+            PROF_BEGIN(PROF_UPDATE);
+            uint32_t update_start = time_us_32();
+            for (int step = 0; step < sim_steps; step++) {
+                // Fresh input (and btnp() edges) for every simulation step
+                if (step > 0) update_buttons();
+                game_update();
+            }
+            update_us = (time_us_32() - update_start) / sim_steps;
+            PROF_END(PROF_UPDATE);
+            begin_draw();
             game_draw();
-            // Update audio system (advance note playback)
-            thumbycolor_audio_update();
+#ifdef THUMBYCOLOR_PROFILER
+            if (btn_bumper_r_held) draw_profiler_overlay();
+#endif
             // Convert to RGB565 and send to display
-            render_to_framebuffer();
-            thumbycolor_update(framebuffer);
+            // (on core 1 in dual-core mode, overlapping the next frame)
+            submit_frame(PRESENT_GAME);
         }
 
-        // Wait for vsync (~30 FPS for game)
-        thumbycolor_wait_vsync();
+        // Wait for the next frame deadline (60 Hz, or 30 Hz when adaptive
+        // pacing has dropped the rate)
+        PROF_BEGIN(PROF_VSYNC);
+        int32_t slack_us = thumbycolor_wait_vsync();
+        PROF_END(PROF_VSYNC);
+
+#ifdef THUMBYCOLOR_ADAPTIVE_FPS
+        pace_frame(slack_us, update_us);
+#else
+        (void)slack_us;
+        (void)update_us;
+#endif
+
+#ifdef THUMBYCOLOR_PROFILER
+        profiler_frame_end();
+#endif
+
+#ifdef THUMBYCOLOR_GOVERNOR
+        govern_clock(slack_us);
+#endif
+
+        // Queued saves go to flash one page program (or sector erase) per
+        // frame. The display DMA chain is refilled from an IRQ that cannot
+        // run while flash is written, so let the frame in flight finish
+        // first; flash_safe_execute() then disables interrupts and parks
+        // core 1 (if running) so nothing executes from XIP meanwhile.
+        if (save_journal_busy()) {
+            flush_presentation();
+            save_journal_service();
+#ifdef THUMBYCOLOR_GOVERNOR
+            gov_skip_frame = true;
+#endif
+        }
+
+#ifdef THUMBYCOLOR_REPLAY
+        // A recording covers one game: stop when it returns to the title
+        // (or the run buffer fills up)
+        if (replay_get_mode() == REPLAY_RECORDING) {
+            if ((replay_prev_mode == 2 && cur_mode == 0) || replay_full()) {
+                flush_presentation();
+                replay_stop();
+            }
+            replay_prev_mode = cur_mode;
+        }
+#endif
     }
 
     return 0;
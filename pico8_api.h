@@ -0,0 +1,406 @@
+/*
+ * PICO-8 Drawing API
+ * Screen state and primitives used by hyperspace_game.h
+ *
+ * Shared by the ThumbyColor port (main_thumbycolor.c) and the host benchmark
+ * (host/hyperspace_bench.c). Include once, from a single translation unit,
+ * after SCREEN_WIDTH / SCREEN_HEIGHT are defined. Optional:
+ * - SCREEN_BUFFER_COUNT: number of screen buffers (default 1)
+ * - HYPERSPACE_SCREEN_4BPP: two pixels per screen byte instead of one
+ * - PROF_COUNT(counter, n): profiler counter hook (thumbycolor_profiler.h)
+ * - HOT_FUNC(name): placement of the rasterizer and projection functions in
+ *   hyperspace_game.h (thumbycolor_hw.h)
+ */
+
+#ifndef PICO8_API_H
+#define PICO8_API_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SCREEN_BUFFER_COUNT
+#define SCREEN_BUFFER_COUNT 1
+#endif
+
+#ifndef PROF_COUNT
+#define PROF_COUNT(counter, n) ((void)0)
+#endif
+
+#ifndef HOT_FUNC
+#define HOT_FUNC(name) name
+#endif
+
+// =============================================================================
+// Screen State
+// =============================================================================
+
+// Bytes per screen row. HYPERSPACE_SCREEN_4BPP packs two palette indices
+// per byte, the even column in the low nibble; rows are read and written
+// through screen_get() / screen_put() / screen_fill().
+#ifdef HYPERSPACE_SCREEN_4BPP
+#define SCREEN_ROW_BYTES (SCREEN_WIDTH / 2)
+#else
+#define SCREEN_ROW_BYTES SCREEN_WIDTH
+#endif
+
+// Screen buffers (palette indices, word aligned for row hashing)
+static uint8_t screen_buffers[SCREEN_BUFFER_COUNT][SCREEN_HEIGHT][SCREEN_ROW_BYTES] __attribute__((aligned(4)));
+
+// Current draw target (the back buffer in dual-core mode)
+static uint8_t (*screen)[SCREEN_ROW_BYTES] = screen_buffers[0];
+
+// Columns written per row since the last cls() (x0 > x1: row untouched)
+typedef struct {
+    uint8_t x0[SCREEN_HEIGHT];
+    uint8_t x1[SCREEN_HEIGHT];
+} DirtySpans;
+
+// One set of spans per screen buffer, recorded by the drawing primitives
+static DirtySpans screen_dirty[SCREEN_BUFFER_COUNT];
+static DirtySpans *dirty = &screen_dirty[0];
+
+// Sprite sheet (128x128 pixels, 4-bit palette)
+static uint8_t spritesheet[128][128];
+
+// Opaque (non-zero) texels of each 8x8 sprite cell: one byte per row, bit i
+// for column i. Rebuilt by spr_cache_init() whenever spritesheet changes.
+static uint8_t spr_opaque[256][8];
+
+// Map memory (for mesh data)
+static uint8_t map_memory[0x1000];
+
+// Palette mapping for pal()
+static uint8_t palette_map[16];
+
+// Drawing color
+static uint8_t draw_color = 7;
+
+// Clip region
+static int clip_x1 = 0, clip_y1 = 0;
+static int clip_x2 = SCREEN_WIDTH - 1, clip_y2 = SCREEN_HEIGHT - 1;
+
+// =============================================================================
+// Screen Rows
+// =============================================================================
+
+#ifdef HYPERSPACE_SCREEN_4BPP
+
+static inline uint8_t screen_get(const uint8_t* row, int x) {
+    return (row[x >> 1] >> ((x & 1) * 4)) & 15;
+}
+
+static inline void screen_put(uint8_t* row, int x, uint8_t c) {
+    uint8_t* p = &row[x >> 1];
+    *p = (x & 1) ? (uint8_t)((*p & 0x0F) | (c << 4)) : (uint8_t)((*p & 0xF0) | c);
+}
+
+// Columns x0..x1: odd ends by nibble, the pairs in between with one memset
+static inline void screen_fill(uint8_t* row, int x0, int x1, uint8_t c) {
+    if (x0 & 1) screen_put(row, x0++, c);
+    if (!(x1 & 1)) screen_put(row, x1--, c);
+    if (x0 < x1) memset(&row[x0 >> 1], c * 0x11, (size_t)((x1 - x0 + 1) >> 1));
+}
+
+#else
+
+static inline uint8_t screen_get(const uint8_t* row, int x) {
+    return row[x];
+}
+
+static inline void screen_put(uint8_t* row, int x, uint8_t c) {
+    row[x] = c;
+}
+
+static inline void screen_fill(uint8_t* row, int x0, int x1, uint8_t c) {
+    memset(&row[x0], c, (size_t)(x1 - x0 + 1));
+}
+
+#endif
+
+// =============================================================================
+// Drawing Primitives
+// =============================================================================
+
+// Record that columns x0..x1 of row y were written (coordinates on screen)
+static inline void mark_dirty(int x0, int x1, int y) {
+    if (x0 < dirty->x0[y]) dirty->x0[y] = x0;
+    if (x1 > dirty->x1[y]) dirty->x1[y] = x1;
+    PROF_COUNT(PROF_PIXELS, x1 - x0 + 1);
+}
+
+static void mark_all_dirty(void) {
+    memset(dirty->x0, 0, sizeof(dirty->x0));
+    memset(dirty->x1, SCREEN_WIDTH - 1, sizeof(dirty->x1));
+}
+
+// Hook used by the rasterizer in hyperspace_game.h for PSET_FAST spans
+#define SCREEN_MARK_SPAN(x0, x1, y) mark_dirty((x0), (x1), (y))
+
+static void cls(void) {
+    memset(screen, 0, SCREEN_ROW_BYTES * SCREEN_HEIGHT);
+    memset(dirty->x0, 0xFF, sizeof(dirty->x0));
+    memset(dirty->x1, 0, sizeof(dirty->x1));
+}
+
+static void pset(int x, int y, int c) {
+    if (x >= clip_x1 && x <= clip_x2 && y >= clip_y1 && y <= clip_y2 &&
+        x >= 0 && x < SCREEN_WIDTH && y >= 0 && y < SCREEN_HEIGHT) {
+        screen_put(screen[y], x, palette_map[c & 15]);
+        mark_dirty(x, x, y);
+    }
+}
+
+// Fast pset - uses palette mapping for animation
+// Does not record dirty spans; callers use SCREEN_MARK_SPAN per run
+#define PSET_FAST(x, y, c) screen_put(screen[(y)], (x), palette_map[(c) & 15])
+
+static uint8_t pget(int x, int y) {
+    if (x >= 0 && x < SCREEN_WIDTH && y >= 0 && y < SCREEN_HEIGHT) {
+        return screen_get(screen[y], x);
+    }
+    return 0;
+}
+
+static uint8_t sget(int x, int y) {
+    if (x >= 0 && x < 128 && y >= 0 && y < 128) {
+        return spritesheet[y][x];
+    }
+    return 0;
+}
+
+// Fast texture fetch
+#define SGET_FAST(x, y) (spritesheet[(y)][(x)])
+
+// Clip rectangle intersected with the screen (empty when x1 > x2 or y1 > y2)
+typedef struct {
+    int x1, y1, x2, y2;
+} ClipRect;
+
+static inline ClipRect clip_rect(void) {
+    ClipRect r;
+    r.x1 = clip_x1 > 0 ? clip_x1 : 0;
+    r.y1 = clip_y1 > 0 ? clip_y1 : 0;
+    r.x2 = clip_x2 < SCREEN_WIDTH - 1 ? clip_x2 : SCREEN_WIDTH - 1;
+    r.y2 = clip_y2 < SCREEN_HEIGHT - 1 ? clip_y2 : SCREEN_HEIGHT - 1;
+    return r;
+}
+
+// Fill columns x0..x1 of row y (already clipped) with screen color col
+static inline void hspan(int x0, int x1, int y, uint8_t col) {
+    screen_fill(screen[y], x0, x1, col);
+    mark_dirty(x0, x1, y);
+}
+
+// Cohen-Sutherland outcode
+#define OUT_LEFT   1
+#define OUT_RIGHT  2
+#define OUT_TOP    4
+#define OUT_BOTTOM 8
+
+static inline int outcode(const ClipRect* r, int x, int y) {
+    int code = 0;
+    if (x < r->x1) code |= OUT_LEFT;
+    else if (x > r->x2) code |= OUT_RIGHT;
+    if (y < r->y1) code |= OUT_TOP;
+    else if (y > r->y2) code |= OUT_BOTTOM;
+    return code;
+}
+
+// Minor-axis offset after k major steps of the Bresenham loop in line()
+// (d_major >= d_minor)
+static inline int line_minor(int64_t k, int d_major, int d_minor) {
+    return (int)((2 * k * d_minor + d_major - 1) / (2 * d_major));
+}
+
+// Restrict the major steps [*k0, *k1] of a line to those whose minor offset
+// lies in lo..hi (line_minor() is non-decreasing in k)
+static bool line_clip_minor(int* k0, int* k1, int lo, int hi, int d_major, int d_minor) {
+    if (hi < 0 || lo > hi) return false;
+    if (d_minor == 0) return lo <= 0;
+    if (lo > 0) {
+        int64_t num = (int64_t)(2 * (int64_t)lo - 1) * d_major + 1;
+        int64_t k = (num + 2 * d_minor - 1) / (2 * d_minor);
+        if (k > *k0) *k0 = k > *k1 ? *k1 + 1 : (int)k;
+    }
+    int64_t k = (int64_t)(2 * (int64_t)hi + 1) * d_major / (2 * d_minor);
+    if (k < *k1) *k1 = (int)k;
+    return *k0 <= *k1;
+}
+
+// Same pixels as stepping Bresenham from (x0, y0) through pset(): lines with
+// both ends past one edge are rejected by their outcodes, partly visible
+// lines have their step range clipped exactly and the error term is
+// advanced to the first visible step in closed form, so no time is spent
+// walking off-screen pixels
+static void line(int x0, int y0, int x1, int y1, int c) {
+    ClipRect r = clip_rect();
+    if (r.x1 > r.x2 || r.y1 > r.y2) return;
+    int code0 = outcode(&r, x0, y0);
+    int code1 = outcode(&r, x1, y1);
+    if (code0 & code1) return;
+
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    bool x_major = dx >= dy;
+    int d_major = x_major ? dx : dy;
+    int d_minor = x_major ? dy : dx;
+
+    int k0 = 0, k1 = d_major;
+    if (code0 | code1) {
+        int major0 = x_major ? x0 : y0, minor0 = x_major ? y0 : x0;
+        int s_major = x_major ? sx : sy, s_minor = x_major ? sy : sx;
+        int major_lo = x_major ? r.x1 : r.y1, major_hi = x_major ? r.x2 : r.y2;
+        int minor_lo = x_major ? r.y1 : r.x1, minor_hi = x_major ? r.y2 : r.x2;
+
+        // Steps along each axis that stay inside the rectangle
+        int lo = s_major > 0 ? major_lo - major0 : major0 - major_hi;
+        int hi = s_major > 0 ? major_hi - major0 : major0 - major_lo;
+        if (lo > k0) k0 = lo;
+        if (hi < k1) k1 = hi;
+        if (k0 > k1) return;
+
+        lo = s_minor > 0 ? minor_lo - minor0 : minor0 - minor_hi;
+        hi = s_minor > 0 ? minor_hi - minor0 : minor0 - minor_lo;
+        if (!line_clip_minor(&k0, &k1, lo, hi, d_major, d_minor)) return;
+    }
+
+    // Loop state after k0 steps
+    int m = d_major ? line_minor(k0, d_major, d_minor) : 0;
+    int err;
+    if (x_major) {
+        x0 += sx * k0;
+        y0 += sy * m;
+        err = (int)((int64_t)dx - dy - (int64_t)k0 * dy + (int64_t)m * dx);
+    } else {
+        y0 += sy * k0;
+        x0 += sx * m;
+        err = (int)((int64_t)dx - dy - (int64_t)m * dy + (int64_t)k0 * dx);
+    }
+
+    uint8_t col = palette_map[c & 15];
+    for (int k = k0; ; k++) {
+        screen_put(screen[y0], x0, col);
+        mark_dirty(x0, x0, y0);
+        if (k == k1) break;
+        int e2 = 2 * err;
+        if (e2 > -dy) { err -= dy; x0 += sx; }
+        if (e2 < dx) { err += dx; y0 += sy; }
+    }
+}
+
+static void rectfill(int x0, int y0, int x1, int y1, int c) {
+    if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+    if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
+
+    ClipRect r = clip_rect();
+    if (x0 < r.x1) x0 = r.x1;
+    if (x1 > r.x2) x1 = r.x2;
+    if (y0 < r.y1) y0 = r.y1;
+    if (y1 > r.y2) y1 = r.y2;
+    if (x0 > x1) return;
+
+    uint8_t col = palette_map[c & 15];
+    for (int y = y0; y <= y1; y++) {
+        hspan(x0, x1, y, col);
+    }
+}
+
+// Row y of the disc holds the x with x*x + y*y <= r*r, i.e. one span per
+// row whose half width only needs a few adjustments from the previous row
+static void circfill(int cx, int cy, int r, int c) {
+    ClipRect clip = clip_rect();
+    uint8_t col = palette_map[c & 15];
+    int w = 0;
+    for (int y = -r; y <= r; y++) {
+        int rem = r * r - y * y;
+        while ((w + 1) * (w + 1) <= rem) w++;
+        while (w * w > rem) w--;
+
+        int py = cy + y;
+        if (py < clip.y1 || py > clip.y2) continue;
+        int x0 = cx - w, x1 = cx + w;
+        if (x0 < clip.x1) x0 = clip.x1;
+        if (x1 > clip.x2) x1 = clip.x2;
+        if (x0 <= x1) hspan(x0, x1, py, col);
+    }
+}
+
+static void spr_cache_init(void) {
+    for (int n = 0; n < 256; n++) {
+        const uint8_t* cell = &spritesheet[(n / 16) * 8][(n & 15) * 8];
+        for (int row = 0; row < 8; row++) {
+            uint8_t bits = 0;
+            for (int col = 0; col < 8; col++) {
+                if (cell[row * 128 + col] != 0) bits |= 1 << col;
+            }
+            spr_opaque[n][row] = bits;
+        }
+    }
+}
+
+// Only the opaque texels of each cell row are visited (spr_opaque), after
+// masking the row to the clip rectangle. The texel goes through palette_map
+// twice, as it did through pset().
+static void spr(int n, int x, int y, int w, int h) {
+    int cell_x = n & 15;
+    int sy = (n / 16) * 8;
+    ClipRect r = clip_rect();
+
+    for (int py = 0; py < h * 8; py++) {
+        int ty = y + py;
+        int row = sy + py;
+        if (ty < r.y1 || ty > r.y2 || row < 0) continue;
+        if (row > 127) break;  // sget() returns 0 past the sheet
+
+        const uint8_t* src = spritesheet[row];
+        uint8_t* dst = screen[ty];
+        for (int cx = 0; cx < w && cell_x + cx < 16; cx++) {
+            uint32_t bits = spr_opaque[(row >> 3) * 16 + cell_x + cx][row & 7];
+            int bx = x + cx * 8;
+            int lo = r.x1 - bx, hi = r.x2 - bx;
+            if (lo > 0) bits = lo < 8 ? bits & (0xFFu << lo) : 0;
+            if (hi < 7) bits = hi >= 0 ? bits & ((2u << hi) - 1) : 0;
+            if (bits == 0) continue;
+
+            mark_dirty(bx + __builtin_ctz(bits), bx + 31 - __builtin_clz(bits), ty);
+            const uint8_t* texels = &src[(cell_x + cx) * 8];
+            do {
+                int i = __builtin_ctz(bits);
+                screen_put(dst, bx + i, palette_map[palette_map[texels[i]] & 15]);
+                bits &= bits - 1;
+            } while (bits);
+        }
+    }
+}
+
+static void pal_reset(void) {
+    for (int i = 0; i < 16; i++) palette_map[i] = i;
+}
+
+static void pal(int c0, int c1) {
+    palette_map[c0 & 15] = c1 & 15;
+}
+
+static void clip_set(int x, int y, int w, int h) {
+    clip_x1 = x;
+    clip_y1 = y;
+    clip_x2 = x + w - 1;
+    clip_y2 = y + h - 1;
+}
+
+static void clip_reset(void) {
+    clip_x1 = 0;
+    clip_y1 = 0;
+    clip_x2 = SCREEN_WIDTH - 1;
+    clip_y2 = SCREEN_HEIGHT - 1;
+}
+
+static void color(int c) {
+    draw_color = c & 15;
+}
+
+#endif // PICO8_API_H
@@ -14,17 +14,32 @@
 #include "hardware/adc.h"
 #include "hardware/timer.h"
 #include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/clocks.h"
+#include "hardware/vreg.h"
 #include <string.h>
 #include <stdlib.h>
+#ifdef __ARM_FEATURE_DSP
+#include <arm_acle.h>
+#endif
 
 // SPI instance
 #define SPI_PORT spi0
 #define SPI_BAUDRATE_CMD  (10 * 1000 * 1000)   // 10 MHz for commands
 #define SPI_BAUDRATE_DATA (80 * 1000 * 1000)   // 80 MHz for pixel data
 
-// DMA channel for display
-static int dma_channel = -1;
-static dma_channel_config dma_config;
+// DMA channels for display (used in turn, see DMA Display Update)
+static int display_dma[2] = {-1, -1};
+static dma_channel_config display_dma_config[2];       // Not chained: started by the IRQ
+
+// Guards the display presentation state shared with the DMA IRQ
+static spin_lock_t *display_lock = NULL;
+
+// DMA IRQ priorities (lower is more urgent). A display refill is due within
+// one chunk (~109 us), an audio block within ~11.6 ms, so the display IRQ
+// preempts the audio mix, and other handlers (USB stdio) preempt it too.
+#define DISPLAY_IRQ_PRIORITY (PICO_DEFAULT_IRQ_PRIORITY - 0x40)
+#define AUDIO_IRQ_PRIORITY   (PICO_DEFAULT_IRQ_PRIORITY + 0x40)
 
 // PWM slice for backlight
 static uint backlight_slice;
@@ -262,23 +277,142 @@ void thumbycolor_set_backlight(float brightness) {
 // DMA Display Update
 // =============================================================================
 
+// Frames are streamed in chunks of up to DISPLAY_CHUNK_PIXELS pixels through
+// two DMA channels used in turn. The completion IRQ of one channel starts the
+// other (armed one chunk earlier), then refills its own line buffer with the
+// chunk after next, so palette conversion overlaps the SPI transfer and no
+// full-frame RGB565 buffer is needed.
+//
+// The channels are not chained to each other. With chaining, the IRQ had to
+// re-arm a channel before the other one drained its chunk (~109 us at 75 MHz
+// SPI); a late IRQ resent a stale line buffer and lost track of which
+// channel was running. Now a late IRQ only pauses the SPI clock between two
+// chunks (the 8-entry SPI FIFO covers the usual IRQ latency), and the
+// stream stays in order however long the IRQ is held off.
+//
+// A frame is a list of window rectangles. Each rectangle gets its own
+// CASET/RASET/RAMWR; after its last chunk the IRQ starts the next rectangle
+// once the SPI has drained.
+#define DISPLAY_CHUNK_LINES   4
+#define DISPLAY_CHUNK_PIXELS  (DISPLAY_CHUNK_LINES * SCREEN_WIDTH)
+
+// One queued frame transfer
+typedef struct {
+    const uint16_t *rgb;        // RGB565 pixels sent as-is, or NULL
+    const uint8_t *indexed;     // Palette indices converted per chunk, or NULL
+    const uint16_t *palette;    // 16-entry RGB565 palette for indexed
+    const uint8_t *packed;      // Two palette indices per byte, or NULL
+    const uint32_t *pairs;      // 256-entry RGB565 pair table for packed
+    uint16_t fill;              // Solid color when rgb, indexed and packed are NULL
+    display_rect_t rects[DISPLAY_MAX_RECTS];
+    int num_rects;
+} display_job_t;
+
+// Word aligned for the pair stores of packed jobs
+static uint16_t display_line_buffers[2][DISPLAY_CHUNK_PIXELS] __attribute__((aligned(4)));
+
+// Shared with the DMA completion IRQ (guarded by display_lock)
+static display_job_t display_job;           // Being sent
+static display_job_t display_pending_job;   // Queued behind display_job
+static volatile bool display_busy = false;
+static volatile bool display_has_pending = false;
+static int display_rect;                    // Rectangle being sent
+static int display_rect_lines;              // Lines per chunk for this rectangle
+static int display_rect_chunks;             // Chunks in this rectangle
+static int display_next_chunk;              // Next chunk to prepare
+static int display_chunks_done;             // Chunks fully handed to the SPI
+
 static void dma_init_display(void) {
-    dma_channel = dma_claim_unused_channel(true);
-    dma_config = dma_channel_get_default_config(dma_channel);
+    for (int i = 0; i < 2; i++) {
+        display_dma[i] = dma_claim_unused_channel(true);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config config = dma_channel_get_default_config(display_dma[i]);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+        channel_config_set_dreq(&config, spi_get_dreq(SPI_PORT, true));
+        channel_config_set_read_increment(&config, true);
+        channel_config_set_write_increment(&config, false);
+
+        // Chaining a channel to itself disables chaining
+        channel_config_set_chain_to(&config, display_dma[i]);
+        display_dma_config[i] = config;
+    }
 
-    channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_16);
-    channel_config_set_dreq(&dma_config, spi_get_dreq(SPI_PORT, true));
-    channel_config_set_read_increment(&dma_config, true);
-    channel_config_set_write_increment(&dma_config, false);
+    display_lock = spin_lock_instance(spin_lock_claim_unused(true));
 }
 
-void thumbycolor_update(uint16_t *framebuffer) {
-    // Wait for previous DMA transfer to complete
-    if (dma_channel >= 0) {
-        dma_channel_wait_for_finish_blocking(dma_channel);
+// Returns the RGB565 source for a chunk of the current rectangle, converting
+// into the slot's line buffer unless the source can be read in place
+static const uint16_t *HOT_FUNC(display_prepare_chunk)(int slot, int chunk, uint *count) {
+    const display_job_t *job = &display_job;
+    const display_rect_t *rect = &job->rects[display_rect];
+    int width = rect->x1 - rect->x0 + 1;
+    int y0 = rect->y0 + chunk * display_rect_lines;
+    int lines = rect->y1 - y0 + 1;
+    if (lines > display_rect_lines) lines = display_rect_lines;
+
+    *count = lines * width;
+
+    if (job->rgb && width == SCREEN_WIDTH) {
+        return job->rgb + y0 * SCREEN_WIDTH;
     }
 
-    // Wait for SPI to finish any pending transfers
+    uint16_t *dst = display_line_buffers[slot];
+    for (int y = y0; y < y0 + lines; y++) {
+        int first = y * SCREEN_WIDTH + rect->x0;
+        if (job->indexed) {
+            const uint8_t *src = job->indexed + first;
+            const uint16_t *palette = job->palette;
+            for (int i = 0; i < width; i++) {
+                dst[i] = palette[src[i] & 15];
+            }
+        } else if (job->packed) {
+            // Windows start on even columns and have even widths
+            const uint8_t *src = job->packed + (first >> 1);
+            const uint32_t *pairs = job->pairs;
+            uint32_t *out = (uint32_t *)dst;
+            for (int i = 0; i < width / 2; i++) {
+                out[i] = pairs[src[i]];
+            }
+        } else if (job->rgb) {
+            memcpy(dst, job->rgb + first, width * sizeof(uint16_t));
+        } else {
+            for (int i = 0; i < width; i++) {
+                dst[i] = job->fill;
+            }
+        }
+        dst += width;
+    }
+    return display_line_buffers[slot];
+}
+
+// Arm (but do not trigger) a channel; the IRQ of the other one starts it
+static void HOT_FUNC(display_arm_chunk)(int slot, int chunk) {
+    uint count;
+    const uint16_t *src = display_prepare_chunk(slot, chunk, &count);
+
+    dma_channel_configure(
+        display_dma[slot],
+        &display_dma_config[slot],
+        &spi_get_hw(SPI_PORT)->dr,  // Write to SPI data register
+        src,                         // Read from chunk source
+        count,                       // Number of transfers
+        false                        // Started by display_chunk_done()
+    );
+}
+
+// Must be called with display_lock held or from the DMA IRQ
+static void display_start_rect(void) {
+    const display_rect_t *rect = &display_job.rects[display_rect];
+    int width = rect->x1 - rect->x0 + 1;
+    int height = rect->y1 - rect->y0 + 1;
+
+    // Narrow windows fit more lines into one line buffer
+    display_rect_lines = DISPLAY_CHUNK_PIXELS / width;
+    display_rect_chunks = (height + display_rect_lines - 1) / display_rect_lines;
+
+    // The previous window's last words may still be in the SPI FIFO
     while (spi_is_busy(SPI_PORT)) {
         tight_loop_contents();
     }
@@ -286,8 +420,7 @@ void thumbycolor_update(uint16_t *framebuffer) {
     // Switch to 8-bit for command
     spi_set_format(SPI_PORT, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
 
-    // Set window to full screen
-    gc9107_set_window(0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1);
+    gc9107_set_window(rect->x0, rect->y0, rect->x1, rect->y1);
 
     // Start memory write
     gc9107_write_cmd(GC9107_RAMWR);
@@ -300,24 +433,181 @@ void thumbycolor_update(uint16_t *framebuffer) {
     // Switch to 16-bit SPI Mode 3 for pixel data (TinyCircuits uses CPOL=1, CPHA=1)
     spi_set_format(SPI_PORT, 16, SPI_CPOL_1, SPI_CPHA_1, SPI_MSB_FIRST);
 
-    // DMA transfer
-    dma_channel_configure(
-        dma_channel,
-        &dma_config,
-        &spi_get_hw(SPI_PORT)->dr,  // Write to SPI data register
-        framebuffer,                 // Read from framebuffer
-        SCREEN_WIDTH * SCREEN_HEIGHT, // Number of transfers
-        true                         // Start immediately
-    );
+    // Prime both channels, then kick the first one
+    display_chunks_done = 0;
+    display_arm_chunk(0, 0);
+    if (display_rect_chunks > 1) {
+        display_arm_chunk(1, 1);
+    }
+    display_next_chunk = 2;
+    dma_channel_start(display_dma[0]);
 }
 
-void thumbycolor_clear(uint16_t color) {
-    static uint16_t clear_buffer[SCREEN_WIDTH * SCREEN_HEIGHT];
-    for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
-        clear_buffer[i] = color;
+// Must be called with display_lock held or from the DMA IRQ
+static void display_start_transfer(const display_job_t *job) {
+    display_job = *job;
+    display_busy = true;
+    display_rect = 0;
+    display_start_rect();
+}
+
+static void HOT_FUNC(display_chunk_done)(int slot) {
+    if (++display_chunks_done == display_rect_chunks) {
+        // Rectangle complete: move on to the next one or the queued frame
+        if (++display_rect < display_job.num_rects) {
+            display_start_rect();
+        } else if (display_has_pending) {
+            display_has_pending = false;
+            display_start_transfer(&display_pending_job);
+        } else {
+            display_busy = false;
+        }
+        return;
     }
-    thumbycolor_update(clear_buffer);
-    dma_channel_wait_for_finish_blocking(dma_channel);
+
+    // Send the next chunk (armed on the other channel), then refill this
+    // one behind it. Only one channel is ever active.
+    dma_channel_start(display_dma[slot ^ 1]);
+    if (display_next_chunk < display_rect_chunks) {
+        display_arm_chunk(slot, display_next_chunk++);
+    }
+}
+
+static void HOT_FUNC(display_dma_irq_handler)(void) {
+    uint32_t save = spin_lock_blocking(display_lock);
+
+    // Chunks complete in order, alternating between the two channels
+    while (display_busy) {
+        int slot = display_chunks_done & 1;
+        if (!dma_channel_get_irq0_status(display_dma[slot])) break;
+        dma_channel_acknowledge_irq0(display_dma[slot]);
+        display_chunk_done(slot);
+    }
+
+    spin_unlock(display_lock, save);
+}
+
+// The IRQ is bound to whichever core presents first (core 1 in dual-core mode)
+static void display_irq_init(void) {
+    static bool initialized = false;
+    if (initialized) return;
+    initialized = true;
+
+    dma_channel_set_irq0_enabled(display_dma[0], true);
+    dma_channel_set_irq0_enabled(display_dma[1], true);
+    irq_set_exclusive_handler(DMA_IRQ_0, display_dma_irq_handler);
+    irq_set_priority(DMA_IRQ_0, DISPLAY_IRQ_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+}
+
+static void display_submit(const display_job_t *job) {
+    if (job->num_rects == 0) return;
+
+    display_irq_init();
+
+    // Only one transfer can be queued behind the active one
+    while (display_has_pending) {
+        tight_loop_contents();
+    }
+
+    uint32_t save = spin_lock_blocking(display_lock);
+    if (!display_busy) {
+        display_start_transfer(job);
+    } else {
+        display_pending_job = *job;
+        display_has_pending = true;
+    }
+    spin_unlock(display_lock, save);
+}
+
+// -----------------------------------------------------------------------------
+// Double-buffered RGB565 presentation
+//
+// The HAL owns two RGB565 framebuffers for callers that want to draw in
+// RGB565 directly. They are only linked in if thumbycolor_acquire_framebuffer()
+// is used; the indexed path below needs no framebuffer at all.
+// -----------------------------------------------------------------------------
+
+static uint16_t display_buffers[2][SCREEN_WIDTH * SCREEN_HEIGHT];
+static int display_back = 0;
+
+static bool display_uses_rgb(const uint16_t *framebuffer) {
+    return (display_busy && display_job.rgb == framebuffer) ||
+           (display_has_pending && display_pending_job.rgb == framebuffer);
+}
+
+uint16_t *thumbycolor_acquire_framebuffer(void) {
+    uint16_t *framebuffer = display_buffers[display_back];
+
+    // Block only while this buffer is still being sent or queued
+    while (display_uses_rgb(framebuffer)) {
+        tight_loop_contents();
+    }
+
+    display_back ^= 1;
+    return framebuffer;
+}
+
+static const display_rect_t display_full_rect = {0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1};
+
+void thumbycolor_present(uint16_t *framebuffer) {
+    display_job_t job = { .rgb = framebuffer, .rects = {display_full_rect}, .num_rects = 1 };
+    display_submit(&job);
+}
+
+void thumbycolor_present_indexed(const uint8_t *pixels, const uint16_t *palette) {
+    thumbycolor_present_indexed_rects(pixels, palette, &display_full_rect, 1);
+}
+
+void thumbycolor_present_indexed_rects(const uint8_t *pixels, const uint16_t *palette,
+                                       const display_rect_t *rects, int num_rects) {
+    if (num_rects > DISPLAY_MAX_RECTS) num_rects = DISPLAY_MAX_RECTS;
+
+    display_job_t job = { .indexed = pixels, .palette = palette, .num_rects = num_rects };
+    memcpy(job.rects, rects, num_rects * sizeof(display_rect_t));
+    display_submit(&job);
+}
+
+void thumbycolor_build_pair_lut(const uint16_t *palette, uint32_t *pairs) {
+    for (int i = 0; i < 256; i++) {
+        pairs[i] = palette[i & 15] | ((uint32_t)palette[i >> 4] << 16);
+    }
+}
+
+void thumbycolor_present_packed_rects(const uint8_t *pixels, const uint32_t *pairs,
+                                      const display_rect_t *rects, int num_rects) {
+    if (num_rects > DISPLAY_MAX_RECTS) num_rects = DISPLAY_MAX_RECTS;
+
+    display_job_t job = { .packed = pixels, .pairs = pairs, .num_rects = num_rects };
+    for (int i = 0; i < num_rects; i++) {
+        // Whole bytes: widen to an even first and odd last column
+        job.rects[i] = rects[i];
+        job.rects[i].x0 &= ~1;
+        job.rects[i].x1 |= 1;
+    }
+    display_submit(&job);
+}
+
+bool thumbycolor_present_done(void) {
+    return !display_busy && !display_has_pending;
+}
+
+void thumbycolor_wait_present(void) {
+    while (!thumbycolor_present_done()) {
+        tight_loop_contents();
+    }
+}
+
+void thumbycolor_update(uint16_t *framebuffer) {
+    // Legacy entry point: queue the caller's buffer and return immediately.
+    // The buffer must not be modified until thumbycolor_present_done().
+    thumbycolor_present(framebuffer);
+}
+
+void thumbycolor_clear(uint16_t color) {
+    display_job_t job = { .fill = color, .rects = {display_full_rect}, .num_rects = 1 };
+    display_submit(&job);
+    thumbycolor_wait_present();
 }
 
 // =============================================================================
@@ -386,25 +676,64 @@ uint32_t thumbycolor_time_ms(void) {
     return to_ms_since_boot(get_absolute_time());
 }
 
-void thumbycolor_wait_vsync(void) {
-    // Simple frame timing (~60 FPS)
-    static uint32_t last_frame = 0;
-    uint32_t now = thumbycolor_time_ms();
-    uint32_t elapsed = now - last_frame;
+// Frame pacing runs on a grid of microsecond deadlines. sleep_until() waits
+// on a timer alarm, so frames no longer jitter by the millisecond rounding of
+// thumbycolor_time_ms(). The GC9107 tearing-effect output is not routed to a
+// GPIO on the Thumby Color, so the grid cannot be locked to the panel scan.
+static uint32_t frame_period_us = THUMBYCOLOR_FRAME_US_60HZ;
+static absolute_time_t frame_deadline;
+static bool frame_deadline_set = false;
+static uint32_t frames_missed = 0;
+
+void thumbycolor_set_frame_period(uint32_t period_us) {
+    frame_period_us = period_us;
+}
+
+uint32_t thumbycolor_frames_missed(void) {
+    return frames_missed;
+}
+
+int32_t thumbycolor_wait_vsync(void) {
+    absolute_time_t now = get_absolute_time();
+    if (!frame_deadline_set) {
+        frame_deadline = now;
+        frame_deadline_set = true;
+    }
+    frame_deadline = delayed_by_us(frame_deadline, frame_period_us);
 
-    if (elapsed < 16) {  // ~60 FPS
-        sleep_ms(16 - elapsed);
+    int64_t slack_us = absolute_time_diff_us(now, frame_deadline);
+    if (slack_us > 0) {
+        sleep_until(frame_deadline);
+    } else {
+        // Missed: restart the grid from now rather than rushing the
+        // following frames to catch up
+        frames_missed++;
+        frame_deadline = now;
     }
-    last_frame = thumbycolor_time_ms();
+
+    if (slack_us < -(int64_t)frame_period_us) slack_us = -(int64_t)frame_period_us;
+    return (int32_t)slack_us;
 }
 
 // =============================================================================
 // Audio System (PICO-8 Compatible)
 // =============================================================================
 
+#ifndef AUDIO_SAMPLE_RATE
 #define AUDIO_SAMPLE_RATE 22050
+#endif
 #define AUDIO_PWM_WRAP    255
+
+// The block mixer has int32 headroom for 8 full-scale channels
+#ifndef AUDIO_NUM_CHANNELS
 #define AUDIO_NUM_CHANNELS 4
+#endif
+_Static_assert(AUDIO_NUM_CHANNELS >= 1 && AUDIO_NUM_CHANNELS <= 8, "AUDIO_NUM_CHANNELS must be 1-8");
+
+// Samples rendered per DMA block (~11.6 ms at 22050 Hz)
+#ifndef AUDIO_BLOCK_SAMPLES
+#define AUDIO_BLOCK_SAMPLES 256
+#endif
 
 // PICO-8 frequency table (C-0 to D#-5, 64 notes)
 // PICO-8 uses A4 = 440Hz
@@ -543,7 +872,7 @@ static uint audio_pwm_slice;
 static uint8_t master_volume = 200;
 static uint32_t lfsr = 0xACE1;  // For noise generation
 
-// Waveform generators (return 0-255)
+// Waveform generators (return 0-255), sampled into the wavetables at init
 static inline uint8_t gen_triangle(uint32_t phase) {
     // phase is 0-65535
     uint16_t p = phase >> 8;
@@ -567,77 +896,365 @@ static inline uint8_t gen_noise(void) {
     return (lfsr & 0xFF);
 }
 
-// Generate one audio sample (called at AUDIO_SAMPLE_RATE)
-static uint8_t audio_generate_sample(void) {
-    int32_t mix = 0;
-    int active_count = 0;
-
-    for (int ch = 0; ch < AUDIO_NUM_CHANNELS; ch++) {
-        AudioChannel *c = &audio_channels[ch];
-        if (!c->active || c->volume == 0) continue;
-
-        uint8_t sample = 128;  // Center (silence)
-
-        // Generate waveform based on type
-        switch (c->waveform) {
-            case 0: // Triangle
-                sample = gen_triangle(c->phase);
-                break;
-            case 1: // Tilted saw (like triangle but asymmetric)
-                sample = gen_saw(c->phase);
-                break;
-            case 2: // Saw
-                sample = gen_saw(c->phase);
-                break;
-            case 3: // Square
-                sample = gen_square(c->phase, 128);
-                break;
-            case 4: // Pulse (narrow)
-                sample = gen_square(c->phase, 64);
-                break;
-            case 5: // Organ (square + square/2)
-                sample = (gen_square(c->phase, 128) + gen_square(c->phase * 2, 128)) / 2;
-                break;
-            case 6: // Noise
-                sample = gen_noise();
-                break;
-            case 7: // Phaser (two detuned saws)
-                sample = (gen_saw(c->phase) + gen_saw(c->phase + 8192)) / 2;
-                break;
+// One cycle of each waveform in 256 steps, indexed by the top byte of the
+// 16-bit phase, as signed samples of +-(128 << AUDIO_WAVE_SHIFT). The noise
+// table is refilled from the LFSR for every block that plays noise.
+#define AUDIO_WAVE_NOISE 6
+#define AUDIO_WAVE_SHIFT 6
+static int16_t audio_wavetables[8][256];
+
+// Volume 0-7 as Q15 gains
+static int16_t audio_volume_gain[8];
+
+static void audio_build_tables(void) {
+    for (int i = 0; i < 256; i++) {
+        uint32_t phase = (uint32_t)i << 8;
+        int s[8];
+        s[0] = gen_triangle(phase);
+        s[1] = gen_saw(phase);  // Tilted saw: same as saw for now
+        s[2] = gen_saw(phase);
+        s[3] = gen_square(phase, 128);
+        s[4] = gen_square(phase, 64);
+        s[5] = (gen_square(phase, 128) + gen_square((phase * 2) & 0xFFFF, 128)) / 2;
+        s[6] = 128;
+        s[7] = (gen_saw(phase) + gen_saw((phase + 8192) & 0xFFFF)) / 2;
+        for (int w = 0; w < 8; w++) {
+            audio_wavetables[w][i] = (int16_t)((s[w] - 128) * (1 << AUDIO_WAVE_SHIFT));
+        }
+    }
+    for (int v = 0; v < 8; v++) {
+        audio_volume_gain[v] = (int16_t)(v * 32767 / 7);
+    }
+}
+
+static void audio_refill_noise(void) {
+    for (int i = 0; i < 256; i++) {
+        audio_wavetables[AUDIO_WAVE_NOISE][i] = (int16_t)((gen_noise() - 128) * (1 << AUDIO_WAVE_SHIFT));
+    }
+}
+
+// =============================================================================
+// SFX Sequencer
+// =============================================================================
+
+// Notes are stepped by the block renderer itself, counting output samples,
+// so note changes land on the exact sample and SFX tempo does not depend on
+// the frame rate. audio_channels belongs to the audio DMA IRQ: thumbycolor_sfx()
+// only posts a request per channel, which the IRQ takes at the start of the
+// next block. audio_lock guards the requests (and audio_muted), so the block
+// is mixed with interrupts enabled.
+static spin_lock_t *audio_lock = NULL;
+
+#define AUDIO_REQ_NONE (-3)  // No change
+#define AUDIO_REQ_STOP (-1)
+static int audio_requests[AUDIO_NUM_CHANNELS];  // SFX number, AUDIO_REQ_STOP or AUDIO_REQ_NONE
+
+// Load pitch, waveform and volume of c->note_index
+static void audio_load_note(AudioChannel *c) {
+    uint8_t pitch = c->sfx->notes[c->note_index][0];
+    c->waveform = c->sfx->notes[c->note_index][1];
+    c->volume = c->sfx->notes[c->note_index][2];
+
+    if (pitch < 64 && c->volume > 0) {
+        uint16_t freq = p8_freq_table[pitch];
+        c->phase_inc = (freq * 65536) / AUDIO_SAMPLE_RATE;
+    } else if (c->volume == 0) {
+        // Note with 0 volume = rest, but don't stop channel
+        c->phase_inc = 0;
+    } else {
+        c->active = false;
+    }
+}
+
+static void audio_start_sfx(AudioChannel *c, int n) {
+    c->sfx = &hyperspace_sfx[n];
+    c->note_index = 0;
+    c->sample_count = 0;
+    c->phase = 0;
+
+    // Calculate samples per note based on SFX speed
+    // PICO-8: speed 1 = very fast, speed 255 = very slow
+    // Each speed unit = 1/120 s (183 samples at 22050Hz)
+    c->samples_per_note = c->sfx->speed * (AUDIO_SAMPLE_RATE / 120);
+    if (c->samples_per_note < AUDIO_SAMPLE_RATE / 120) c->samples_per_note = AUDIO_SAMPLE_RATE / 120;
+
+    // Check if this SFX should loop
+    c->looping = (c->sfx->loop_end > c->sfx->loop_start);
+
+    // Set up first note (a leading rest keeps the channel running)
+    c->active = true;
+    audio_load_note(c);
+}
+
+// Apply the requests posted since the last block (audio_lock held)
+static void audio_take_requests(void) {
+    for (int i = 0; i < AUDIO_NUM_CHANNELS; i++) {
+        int n = audio_requests[i];
+        if (n == AUDIO_REQ_NONE) continue;
+        audio_requests[i] = AUDIO_REQ_NONE;
+        if (n == AUDIO_REQ_STOP) {
+            audio_channels[i].active = false;
+        } else {
+            audio_start_sfx(&audio_channels[i], n);
+        }
+    }
+}
+
+static void audio_next_note(AudioChannel *c) {
+    c->sample_count = 0;
+    c->note_index++;
+
+    // Check for loop or end
+    if (c->looping && c->note_index >= c->sfx->loop_end) {
+        c->note_index = c->sfx->loop_start;
+    } else if (c->note_index >= 32) {
+        c->active = false;
+        return;
+    }
+
+    audio_load_note(c);
+}
+
+// =============================================================================
+// DMA Audio Output
+// =============================================================================
+
+// Samples are rendered a block at a time into two buffers that DMA feeds to
+// the PWM compare register, paced by a DMA timer at AUDIO_SAMPLE_RATE. The two
+// channels are chained to each other; when one finishes, the other starts on
+// the second buffer and the completion IRQ renders the next block into the
+// buffer just played. That is one interrupt per AUDIO_BLOCK_SAMPLES samples
+// instead of one per sample.
+//
+// Each buffer is aligned to its size and read through a DMA address ring, so
+// a channel always wraps back to the start of its own buffer. When the IRQ
+// is late (interrupts off for longer than a block), the chain replays a
+// stale block rather than running on into whatever follows in RAM.
+//
+// Each word is written to the whole CC register, with the level in the half
+// of the buzzer's PWM channel (the other channel of the slice is unused).
+#define AUDIO_BUFFER_BYTES (AUDIO_BLOCK_SAMPLES * 4)
+_Static_assert((AUDIO_BLOCK_SAMPLES & (AUDIO_BLOCK_SAMPLES - 1)) == 0 && AUDIO_BUFFER_BYTES <= 32768,
+               "AUDIO_BLOCK_SAMPLES must be a power of two for the DMA read ring");
+static uint32_t audio_buffers[2][AUDIO_BLOCK_SAMPLES] __attribute__((aligned(AUDIO_BUFFER_BYTES)));
+static int32_t audio_mix[AUDIO_BLOCK_SAMPLES];
+static uint8_t audio_mix_count[AUDIO_BLOCK_SAMPLES];  // Audible channels per sample
+static int audio_dma[2] = {-1, -1};
+static int audio_dma_timer = -1;
+static uint audio_cc_shift;
+static bool audio_muted = false;
+
+// One channel's note for a run of samples, ready for the mixer. Rests and
+// idle channels have gain 0. Noise is read straight through its table from
+// the run's position in the block instead of at the note's pitch, staggered
+// per channel so that two noise channels don't play the same samples.
+typedef struct {
+    const int16_t *table;
+    uint32_t phase;
+    uint32_t inc;
+    int16_t gain;
+} AudioVoice;
+
+static bool audio_noise_fresh;  // Noise table refilled for this block
+
+static void audio_voice_load(AudioVoice *v, const AudioChannel *c, int offset) {
+    v->table = audio_wavetables[0];
+    v->phase = 0;
+    v->inc = 0;
+    v->gain = 0;
+    if (!c || c->volume == 0) return;
+
+    v->table = audio_wavetables[c->waveform];
+    v->gain = audio_volume_gain[c->volume];
+    if (c->waveform == AUDIO_WAVE_NOISE) {
+        if (!audio_noise_fresh) {
+            audio_refill_noise();
+            audio_noise_fresh = true;
         }
+        v->phase = (uint32_t)(offset + (c - audio_channels) * 61) << 8;
+        v->inc = 1 << 8;
+    } else {
+        v->phase = c->phase;
+        v->inc = c->phase_inc;
+    }
+}
 
-        // Apply volume (0-7 -> 0-255)
-        int32_t vol_sample = ((int32_t)sample - 128) * c->volume / 7;
-        mix += vol_sample;
+static inline uint32_t audio_pack(int16_t lo, int16_t hi) {
+    return (uint16_t)lo | ((uint32_t)(uint16_t)hi << 16);
+}
 
-        // Advance phase
-        c->phase += c->phase_inc;
+// acc + lo(x) * lo(y) + hi(x) * hi(y), signed 16-bit halves
+static inline int32_t audio_mac2(uint32_t x, uint32_t y, int32_t acc) {
+#ifdef __ARM_FEATURE_DSP
+    return __smlad(x, y, acc);
+#else
+    // Hazard3 (RISC-V) has no packed multiply: two 16x16 multiplies
+    return acc + (int16_t)x * (int16_t)y + (int16_t)(x >> 16) * (int16_t)(y >> 16);
+#endif
+}
 
-        active_count++;
+// Add n samples of two voices to audio_mix, one dual multiply-accumulate
+// per sample
+static void HOT_FUNC(audio_mix_pair)(const AudioVoice *a, const AudioVoice *b, int32_t *mix, uint8_t *count, int n) {
+    const int16_t *ta = a->table, *tb = b->table;
+    uint32_t pa = a->phase, pb = b->phase;
+    uint32_t ia = a->inc, ib = b->inc;
+    uint32_t gains = audio_pack(a->gain, b->gain);
+    uint8_t audible = (a->gain != 0) + (b->gain != 0);
+
+    for (int i = 0; i < n; i++) {
+        uint32_t samples = audio_pack(ta[(pa >> 8) & 255], tb[(pb >> 8) & 255]);
+        mix[i] = audio_mac2(samples, gains, mix[i]);
+        count[i] += audible;
+        pa += ia;
+        pb += ib;
     }
+}
 
-    // Mix and clamp
-    if (active_count > 0) {
-        mix = mix / active_count;  // Average channels
+static bool audio_channel_playing(const AudioChannel *c) {
+    return c && c->active && c->sfx;
+}
+
+// Render a pair of channels (b may be NULL), split into runs at the note
+// changes of either one
+static void HOT_FUNC(audio_render_pair)(AudioChannel *a, AudioChannel *b, int n) {
+    int i = 0;
+    while (i < n) {
+        bool on_a = audio_channel_playing(a);
+        bool on_b = audio_channel_playing(b);
+        if (!on_a && !on_b) break;
+
+        int run = n - i;
+        if (on_a && a->samples_per_note - a->sample_count < run) run = a->samples_per_note - a->sample_count;
+        if (on_b && b->samples_per_note - b->sample_count < run) run = b->samples_per_note - b->sample_count;
+
+        // Rests keep time but are not mixed (nor counted in the average)
+        AudioVoice va, vb;
+        audio_voice_load(&va, on_a ? a : NULL, i);
+        audio_voice_load(&vb, on_b ? b : NULL, i);
+        if (va.gain || vb.gain) audio_mix_pair(&va, &vb, &audio_mix[i], &audio_mix_count[i], run);
+
+        AudioChannel *pair[2] = { on_a ? a : NULL, on_b ? b : NULL };
+        for (int k = 0; k < 2; k++) {
+            AudioChannel *c = pair[k];
+            if (!c) continue;
+            c->phase += c->phase_inc * (uint32_t)run;
+            c->sample_count += run;
+            if (c->sample_count >= c->samples_per_note) audio_next_note(c);
+        }
+        i += run;
+    }
+}
+
+// Render one block of PWM compare words
+static void HOT_FUNC(audio_render_block)(uint32_t *out, int n) {
+    memset(audio_mix, 0, n * sizeof(audio_mix[0]));
+    memset(audio_mix_count, 0, n * sizeof(audio_mix_count[0]));
+    audio_noise_fresh = false;
+
+    for (int ch = 0; ch < AUDIO_NUM_CHANNELS; ch += 2) {
+        AudioChannel *b = ch + 1 < AUDIO_NUM_CHANNELS ? &audio_channels[ch + 1] : NULL;
+        audio_render_pair(&audio_channels[ch], b, n);
     }
 
-    // Convert to unsigned and apply master volume
-    int32_t out = 128 + (mix * master_volume / 255);
-    if (out < 0) out = 0;
-    if (out > 255) out = 255;
+    // Channel average and master volume folded into one 16.16 gain per
+    // audible channel count, so the per-sample divides become a multiply.
+    // The mix is in Q15 of the table samples; k audible channels stay under
+    // k << (7 + AUDIO_WAVE_SHIFT) after the shift, so the product fits.
+    int32_t gain[AUDIO_NUM_CHANNELS + 1];
+    gain[0] = 0;
+    for (int k = 1; k <= AUDIO_NUM_CHANNELS; k++) {
+        gain[k] = (int32_t)(((uint32_t)master_volume << 16) / (255u * k));
+    }
 
-    return (uint8_t)out;
+    for (int i = 0; i < n; i++) {
+        int32_t level = 128 + (((audio_mix[i] >> 15) * gain[audio_mix_count[i]]) >> (16 + AUDIO_WAVE_SHIFT));
+        if (level < 0) level = 0;
+        if (level > AUDIO_PWM_WRAP) level = AUDIO_PWM_WRAP;
+        out[i] = (uint32_t)level << audio_cc_shift;
+    }
 }
 
-// Timer callback for audio generation
-static volatile bool audio_timer_fired = false;
-static struct repeating_timer audio_timer;
+static void audio_fill_silence(uint32_t *out, int n) {
+    for (int i = 0; i < n; i++) out[i] = 128u << audio_cc_shift;
+}
 
-static bool audio_timer_callback(struct repeating_timer *t) {
-    (void)t;
-    uint8_t sample = audio_generate_sample();
-    pwm_set_gpio_level(GPIO_AUDIO_PWM, sample);
-    return true;
+// Runs below the display IRQ's priority: only taking the requests masks
+// interrupts, so a display refill can preempt the mix
+static void HOT_FUNC(audio_dma_irq_handler)(void) {
+    for (int i = 0; i < 2; i++) {
+        if (!dma_channel_get_irq1_status(audio_dma[i])) continue;
+        dma_channel_acknowledge_irq1(audio_dma[i]);
+
+        uint32_t save = spin_lock_blocking(audio_lock);
+        audio_take_requests();
+        bool muted = audio_muted;
+        spin_unlock(audio_lock, save);
+
+        // The other channel is playing its buffer now. This one's read ring
+        // has wrapped to the start of its buffer and the transfer count
+        // reloads when the chain triggers it again.
+        if (muted) {
+            audio_fill_silence(audio_buffers[i], AUDIO_BLOCK_SAMPLES);
+        } else {
+            audio_render_block(audio_buffers[i], AUDIO_BLOCK_SAMPLES);
+        }
+    }
+}
+
+// Closest X/Y fraction of clk_sys to AUDIO_SAMPLE_RATE (16-bit X and Y)
+static void audio_apply_sample_rate(void) {
+    uint32_t sys_hz = clock_get_hz(clk_sys);
+    uint32_t best_num = 1, best_den = 65535;
+    uint32_t best_err = UINT32_MAX;
+
+    for (uint32_t num = 1; num <= 65535; num++) {
+        uint64_t den = ((uint64_t)sys_hz * num + AUDIO_SAMPLE_RATE / 2) / AUDIO_SAMPLE_RATE;
+        if (den > 65535) break;
+        if (den == 0) continue;
+        uint64_t rate = (uint64_t)sys_hz * num / den;
+        uint32_t err = (uint32_t)(rate > AUDIO_SAMPLE_RATE ? rate - AUDIO_SAMPLE_RATE : AUDIO_SAMPLE_RATE - rate);
+        if (err < best_err) {
+            best_err = err;
+            best_num = num;
+            best_den = (uint32_t)den;
+        }
+    }
+
+    dma_timer_set_fraction(audio_dma_timer, (uint16_t)best_num, (uint16_t)best_den);
+}
+
+static void audio_dma_init(void) {
+    audio_cc_shift = pwm_gpio_to_channel(GPIO_AUDIO_PWM) == PWM_CHAN_B ? 16 : 0;
+
+    audio_dma_timer = dma_claim_unused_timer(true);
+    audio_apply_sample_rate();
+
+    for (int i = 0; i < 2; i++) {
+        audio_dma[i] = dma_claim_unused_channel(true);
+        audio_render_block(audio_buffers[i], AUDIO_BLOCK_SAMPLES);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config config = dma_channel_get_default_config(audio_dma[i]);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+        channel_config_set_dreq(&config, dma_get_timer_dreq(audio_dma_timer));
+        channel_config_set_read_increment(&config, true);
+        channel_config_set_write_increment(&config, false);
+        channel_config_set_ring(&config, false, __builtin_ctz(AUDIO_BUFFER_BYTES));
+        channel_config_set_chain_to(&config, audio_dma[i ^ 1]);
+        dma_channel_configure(audio_dma[i], &config, &pwm_hw->slice[audio_pwm_slice].cc,
+                              audio_buffers[i], AUDIO_BLOCK_SAMPLES, false);
+    }
+
+    // DMA_IRQ_0 belongs to the display
+    dma_channel_set_irq1_enabled(audio_dma[0], true);
+    dma_channel_set_irq1_enabled(audio_dma[1], true);
+    irq_set_exclusive_handler(DMA_IRQ_1, audio_dma_irq_handler);
+    irq_set_priority(DMA_IRQ_1, AUDIO_IRQ_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_start(audio_dma[0]);
 }
 
 void thumbycolor_audio_init(void) {
@@ -658,107 +1275,81 @@ void thumbycolor_audio_init(void) {
     // Start at center (silence)
     pwm_set_gpio_level(GPIO_AUDIO_PWM, 128);
 
+    audio_lock = spin_lock_instance(spin_lock_claim_unused(true));
+
+    audio_build_tables();
+
     // Initialize channels
     for (int i = 0; i < AUDIO_NUM_CHANNELS; i++) {
         audio_channels[i].active = false;
         audio_channels[i].sfx = NULL;
+        audio_requests[i] = AUDIO_REQ_NONE;
     }
 
-    // Start audio timer (~22kHz)
-    add_repeating_timer_us(-45, audio_timer_callback, NULL, &audio_timer);  // ~22kHz
+    // Start block output (~22kHz)
+    audio_dma_init();
 }
 
 void thumbycolor_sfx(int n, int channel) {
     if (channel < 0 || channel >= AUDIO_NUM_CHANNELS) return;
+    if (n >= (int)NUM_SFX || n < -2) return;
 
-    AudioChannel *c = &audio_channels[channel];
-
-    if (n == -1) {
-        // Stop this channel
-        c->active = false;
-        return;
-    }
-
+    // Taken by the IRQ when it renders the next block; a later request for
+    // the same channel replaces an earlier one
+    uint32_t save = spin_lock_blocking(audio_lock);
     if (n == -2) {
         // Stop all channels
         for (int i = 0; i < AUDIO_NUM_CHANNELS; i++) {
-            audio_channels[i].active = false;
+            audio_requests[i] = AUDIO_REQ_STOP;
         }
-        return;
-    }
-
-    if (n < 0 || n >= (int)NUM_SFX) return;
-
-    // Start playing SFX
-    c->sfx = &hyperspace_sfx[n];
-    c->note_index = 0;
-    c->sample_count = 0;
-    c->phase = 0;
-
-    // Calculate samples per note based on SFX speed
-    // PICO-8: speed 1 = very fast, speed 255 = very slow
-    // Each speed unit = 183 samples at 22050Hz (approximately)
-    c->samples_per_note = c->sfx->speed * 183;
-    if (c->samples_per_note < 183) c->samples_per_note = 183;
-
-    // Set up first note
-    uint8_t pitch = c->sfx->notes[0][0];
-    c->waveform = c->sfx->notes[0][1];
-    c->volume = c->sfx->notes[0][2];
-
-    // Calculate phase increment for frequency
-    if (pitch < 64 && c->volume > 0) {
-        uint16_t freq = p8_freq_table[pitch];
-        c->phase_inc = (freq * 65536) / AUDIO_SAMPLE_RATE;
-        c->active = true;
     } else {
-        c->active = false;
+        // Start playing SFX n, or stop this channel (-1)
+        audio_requests[channel] = n;
     }
+    spin_unlock(audio_lock, save);
+}
 
-    // Check if this SFX should loop
-    c->looping = (c->sfx->loop_end > c->sfx->loop_start);
+void thumbycolor_set_volume(uint8_t volume) {
+    master_volume = volume;
 }
 
-void thumbycolor_audio_update(void) {
-    // Advance note positions for all active channels
-    for (int ch = 0; ch < AUDIO_NUM_CHANNELS; ch++) {
-        AudioChannel *c = &audio_channels[ch];
-        if (!c->active || !c->sfx) continue;
+void thumbycolor_audio_mute(bool mute) {
+    uint32_t save = spin_lock_blocking(audio_lock);
+    audio_muted = mute;
+    // Both buffers, so the DMA ring replays silence while the IRQ is held off
+    if (mute) {
+        for (int i = 0; i < 2; i++) audio_fill_silence(audio_buffers[i], AUDIO_BLOCK_SAMPLES);
+    }
+    spin_unlock(audio_lock, save);
+}
 
-        c->sample_count += AUDIO_SAMPLE_RATE / 60;  // Samples per frame at 60fps
+// =============================================================================
+// System Clock
+// =============================================================================
 
-        if (c->sample_count >= c->samples_per_note) {
-            c->sample_count = 0;
-            c->note_index++;
+// Time for the regulator to reach a higher voltage before the clock goes up
+#define VREG_SETTLE_US 1000
 
-            // Check for loop or end
-            if (c->looping && c->note_index >= c->sfx->loop_end) {
-                c->note_index = c->sfx->loop_start;
-            } else if (c->note_index >= 32) {
-                c->active = false;
-                continue;
-            }
+bool thumbycolor_set_sys_clock(uint32_t sys_khz, uint32_t vreg_voltage) {
+    bool faster = (uint64_t)sys_khz * 1000 > clock_get_hz(clk_sys);
+    if (faster) {
+        vreg_set_voltage((enum vreg_voltage)vreg_voltage);
+        busy_wait_us(VREG_SETTLE_US);
+    }
 
-            // Update note parameters
-            uint8_t pitch = c->sfx->notes[c->note_index][0];
-            c->waveform = c->sfx->notes[c->note_index][1];
-            c->volume = c->sfx->notes[c->note_index][2];
-
-            if (pitch < 64 && c->volume > 0) {
-                uint16_t freq = p8_freq_table[pitch];
-                c->phase_inc = (freq * 65536) / AUDIO_SAMPLE_RATE;
-            } else if (c->volume == 0) {
-                // Note with 0 volume = rest, but don't stop channel
-                c->phase_inc = 0;
-            } else {
-                c->active = false;
-            }
-        }
+    // Also moves clk_peri, which the SPI and UART divide down from
+    if (!set_sys_clock_khz(sys_khz, false)) {
+        return false;
+    }
+    if (!faster) {
+        vreg_set_voltage((enum vreg_voltage)vreg_voltage);
     }
-}
 
-void thumbycolor_set_volume(uint8_t volume) {
-    master_volume = volume;
+    // Dividers set for the old clock would now run the panel too fast (or
+    // needlessly slow) and the audio at the wrong pitch
+    spi_set_baudrate(SPI_PORT, SPI_BAUDRATE_DATA);
+    audio_apply_sample_rate();
+    return true;
 }
 
 // =============================================================================
@@ -15,9 +15,33 @@
 #define SCREEN_WIDTH  128
 #define SCREEN_HEIGHT 128
 
+// Hot-path placement (RAM_HOT_PATHS build option): HOT_FUNC(name) functions
+// are copied to SRAM at boot instead of executing in place from flash, and
+// HOT_SCRATCH_X(name) data lives in the 4KB scratch X bank
+#ifdef HYPERSPACE_RAM_HOT_PATHS
+#include "pico.h"
+#define HOT_FUNC(name) __not_in_flash_func(name)
+#define HOT_SCRATCH_X(name) __scratch_x(name)
+#else
+#define HOT_FUNC(name) name
+#define HOT_SCRATCH_X(name)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Color type (RGB565)
 typedef uint16_t color_t;
 
+// Display window (inclusive pixel coordinates)
+typedef struct {
+    uint8_t x0, y0, x1, y1;
+} display_rect_t;
+
+// Maximum windows per partial display update
+#define DISPLAY_MAX_RECTS 16
+
 // =============================================================================
 // GPIO Pin Definitions (from TinyCircuits Tiny Game Engine)
 // =============================================================================
@@ -86,16 +110,60 @@ void thumbycolor_init(void);
 
 // Display
 void thumbycolor_set_backlight(float brightness);  // 0.0 - 1.0
-void thumbycolor_update(uint16_t *framebuffer);
+void thumbycolor_update(uint16_t *framebuffer);     // Same as thumbycolor_present()
 void thumbycolor_clear(uint16_t color);
 
+// Double-buffered display (non-blocking)
+// acquire: next HAL-owned back buffer, waits only if it is still being sent
+// present: queue a buffer for sending, returns immediately
+uint16_t *thumbycolor_acquire_framebuffer(void);
+void thumbycolor_present(uint16_t *framebuffer);
+bool thumbycolor_present_done(void);
+
+// Streamed palette presentation (no RGB565 framebuffer)
+// pixels: SCREEN_WIDTH*SCREEN_HEIGHT palette indices, palette: 16 RGB565 entries.
+// Converted a few lines at a time while sending; both must stay unchanged
+// until thumbycolor_present_done().
+void thumbycolor_present_indexed(const uint8_t *pixels, const uint16_t *palette);
+
+// Partial update: send only the given windows (at most DISPLAY_MAX_RECTS).
+// The panel keeps its previous contents everywhere else.
+void thumbycolor_present_indexed_rects(const uint8_t *pixels, const uint16_t *palette,
+                                       const display_rect_t *rects, int num_rects);
+
+// Packed presentation: pixels holds two palette indices per byte (even
+// column in the low nibble, SCREEN_WIDTH/2 bytes per row), and pairs maps a
+// byte straight to both RGB565 pixels (even column in the low half), as
+// built by thumbycolor_build_pair_lut(). Windows are widened to whole bytes.
+// Both must stay unchanged until thumbycolor_present_done().
+void thumbycolor_build_pair_lut(const uint16_t *palette, uint32_t *pairs);
+void thumbycolor_present_packed_rects(const uint8_t *pixels, const uint32_t *pairs,
+                                      const display_rect_t *rects, int num_rects);
+void thumbycolor_wait_present(void);
+
 // Input
 uint32_t thumbycolor_get_buttons(void);
 bool thumbycolor_button_pressed(uint32_t button);
 
 // Timing
 uint32_t thumbycolor_time_ms(void);
-void thumbycolor_wait_vsync(void);
+
+// Frame pacing: periods of 60 Hz and 30 Hz presentation
+#define THUMBYCOLOR_FRAME_US_60HZ 16667
+#define THUMBYCOLOR_FRAME_US_30HZ 33333
+
+// Sleep until the next frame deadline (one period after the previous one).
+// Returns the slack in microseconds: time that was left before the deadline,
+// or negative when the frame was late (the deadline grid then restarts).
+int32_t thumbycolor_wait_vsync(void);
+void thumbycolor_set_frame_period(uint32_t period_us);
+uint32_t thumbycolor_frames_missed(void);
+
+// Switch clk_sys (and clk_peri with it) to sys_khz at core voltage
+// vreg_voltage (an enum vreg_voltage value), then re-derive the SPI pixel
+// clock and the audio sample timer. Returns false when the PLL cannot make
+// sys_khz. No display transfer may be in flight.
+bool thumbycolor_set_sys_clock(uint32_t sys_khz, uint32_t vreg_voltage);
 
 // Utility
 void thumbycolor_set_led(uint8_t r, uint8_t g, uint8_t b);
@@ -113,15 +181,21 @@ void thumbycolor_audio_init(void);
 // channel: Audio channel (0-3)
 void thumbycolor_sfx(int n, int channel);
 
-// Update audio system (call each frame)
-void thumbycolor_audio_update(void);
-
 // Set master volume (0-255)
 void thumbycolor_set_volume(uint8_t volume);
 
+// Hold the buzzer at its center level, e.g. around a flash erase that keeps
+// the audio IRQ off for longer than a block. Sound effects resume where they
+// stopped when unmuted.
+void thumbycolor_audio_mute(bool mute);
+
 // RGB565 color conversion
 static inline uint16_t thumbycolor_rgb(uint8_t r, uint8_t g, uint8_t b) {
     return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
 }
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // THUMBYCOLOR_HW_H
@@ -0,0 +1,153 @@
+/*
+ * ThumbyColor Frame Profiler Implementation
+ *
+ * Times phases with the core's cycle counter (DWT CYCCNT on Cortex-M33,
+ * mcycle on Hazard3) instead of the millisecond system clock.
+ */
+
+#include "thumbycolor_profiler.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#if defined(__riscv)
+#include "hardware/riscv.h"
+#else
+#include "hardware/structs/m33.h"
+#endif
+#include <stdio.h>
+#include <string.h>
+
+// Frames averaged into each stdio summary (~5 s at 60 FPS)
+#ifndef PROFILER_REPORT_FRAMES
+#define PROFILER_REPORT_FRAMES 300
+#endif
+
+static const char* const phase_names[PROF_NUM_PHASES] = {
+    "UPDATE", "XFORM", "BG", "NME", "LASER", "SHIP", "HUD", "PRESNT", "WAIT", "VSYNC"
+};
+
+uint32_t profiler_counters[PROF_NUM_COUNTERS];
+
+// Frame being measured
+static uint32_t phase_start[PROF_NUM_PHASES];
+static uint32_t phase_cycles[PROF_NUM_PHASES];
+static uint32_t frame_start;
+
+// Last finished frame
+static uint32_t last_frame_cycles;
+static uint32_t last_phase_cycles[PROF_NUM_PHASES];
+static uint32_t last_counters[PROF_NUM_COUNTERS];
+
+// Sums for the periodic report
+static uint64_t sum_frame_cycles;
+static uint64_t sum_phase_cycles[PROF_NUM_PHASES];
+static uint64_t sum_counters[PROF_NUM_COUNTERS];
+static int report_frames;
+
+static uint32_t cycles_per_us = 1;
+
+// =============================================================================
+// Cycle Counter
+// =============================================================================
+
+static inline uint32_t read_cycles(void) {
+#if defined(__riscv)
+    return (uint32_t)riscv_read_csr(mcycle);
+#else
+    return m33_hw->dwt_cyccnt;
+#endif
+}
+
+static uint32_t cycles_to_us(uint64_t cycles) {
+    return (uint32_t)(cycles / cycles_per_us);
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+void profiler_init(void) {
+#if defined(__riscv)
+    // Hazard3 resets with the cycle counter inhibited
+    riscv_clear_csr(mcountinhibit, 1u);
+#else
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    m33_hw->dwt_cyccnt = 0;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+#endif
+    profiler_clock_changed();
+
+    memset(phase_cycles, 0, sizeof(phase_cycles));
+    memset(profiler_counters, 0, sizeof(profiler_counters));
+    frame_start = read_cycles();
+}
+
+void profiler_begin(profiler_phase_t phase) {
+    phase_start[phase] = read_cycles();
+}
+
+// Phases may be entered several times per frame; time accumulates
+void profiler_end(profiler_phase_t phase) {
+    phase_cycles[phase] += read_cycles() - phase_start[phase];
+}
+
+void profiler_frame_end(void) {
+    uint32_t now = read_cycles();
+    last_frame_cycles = now - frame_start;
+    frame_start = now;
+
+    memcpy(last_phase_cycles, phase_cycles, sizeof(phase_cycles));
+    memcpy(last_counters, profiler_counters, sizeof(profiler_counters));
+    memset(phase_cycles, 0, sizeof(phase_cycles));
+    memset(profiler_counters, 0, sizeof(profiler_counters));
+
+    sum_frame_cycles += last_frame_cycles;
+    for (int i = 0; i < PROF_NUM_PHASES; i++) sum_phase_cycles[i] += last_phase_cycles[i];
+    for (int i = 0; i < PROF_NUM_COUNTERS; i++) sum_counters[i] += last_counters[i];
+
+    if (++report_frames < PROFILER_REPORT_FRAMES) return;
+
+    // Averages over the report window, in microseconds
+    printf("prof: frame %lu us |", (unsigned long)cycles_to_us(sum_frame_cycles / report_frames));
+    for (int i = 0; i < PROF_NUM_PHASES; i++) {
+        printf(" %s %lu", phase_names[i], (unsigned long)cycles_to_us(sum_phase_cycles[i] / report_frames));
+    }
+    uint32_t submitted = (uint32_t)(sum_counters[PROF_TRIS_SUBMITTED] / report_frames);
+    uint32_t rasterized = (uint32_t)(sum_counters[PROF_TRIS_RASTERIZED] / report_frames);
+    printf(" | tris %lu raster %lu culled %lu pixels %lu covered %lu | clk %lu MHz\n",
+           (unsigned long)submitted, (unsigned long)rasterized,
+           (unsigned long)(submitted - rasterized),
+           (unsigned long)(sum_counters[PROF_PIXELS] / report_frames),
+           (unsigned long)(sum_counters[PROF_PIXELS_COVERED] / report_frames),
+           (unsigned long)cycles_per_us);
+
+    sum_frame_cycles = 0;
+    memset(sum_phase_cycles, 0, sizeof(sum_phase_cycles));
+    memset(sum_counters, 0, sizeof(sum_counters));
+    report_frames = 0;
+}
+
+void profiler_clock_changed(void) {
+    cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+    if (cycles_per_us == 0) cycles_per_us = 1;
+
+    sum_frame_cycles = 0;
+    memset(sum_phase_cycles, 0, sizeof(sum_phase_cycles));
+    memset(sum_counters, 0, sizeof(sum_counters));
+    report_frames = 0;
+}
+
+uint32_t profiler_frame_us(void) {
+    return cycles_to_us(last_frame_cycles);
+}
+
+uint32_t profiler_phase_us(profiler_phase_t phase) {
+    return cycles_to_us(last_phase_cycles[phase]);
+}
+
+uint32_t profiler_count(profiler_counter_t counter) {
+    return last_counters[counter];
+}
+
+const char* profiler_phase_name(profiler_phase_t phase) {
+    return phase_names[phase];
+}
@@ -0,0 +1,81 @@
+/*
+ * ThumbyColor Frame Profiler
+ * Per-phase cycle-counter timing and per-frame draw counters
+ *
+ * Enabled with -DPROFILER=ON (defines THUMBYCOLOR_PROFILER). Without it the
+ * PROF_* hooks compile to nothing and thumbycolor_profiler.c is not built.
+ */
+
+#ifndef THUMBYCOLOR_PROFILER_H
+#define THUMBYCOLOR_PROFILER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timed phases of one frame on core 0
+typedef enum {
+    PROF_UPDATE,        // game_update()
+    PROF_TRANSFORM,     // transform_vert()
+    PROF_BACKGROUND,    // Background stars, sun, trails
+    PROF_ENEMIES,       // Enemy explosions and rasterization
+    PROF_LASERS,        // Player and enemy lasers
+    PROF_SHIP,          // Aim, ship rasterization, lens flare
+    PROF_HUD,           // HUD text and fade
+    PROF_PRESENT,       // Dirty rects + starting the display transfer (or handing off to core 1)
+    PROF_PRESENT_WAIT,  // Blocked on the display / core 1 for a free screen buffer
+    PROF_VSYNC,         // Sleep in thumbycolor_wait_vsync()
+    PROF_NUM_PHASES
+} profiler_phase_t;
+
+// Per-frame event counters
+typedef enum {
+    PROF_TRIS_SUBMITTED,   // rasterize_tri() calls
+    PROF_TRIS_RASTERIZED,  // Triangles that survived culling
+    PROF_PIXELS,           // Pixels written (sum of marked spans, overdraw included)
+    PROF_PIXELS_COVERED,   // Pixels skipped by the span buffer (overdraw removed, HYPERSPACE_SBUFFER)
+    PROF_NUM_COUNTERS
+} profiler_counter_t;
+
+#ifdef THUMBYCOLOR_PROFILER
+
+// Counters for the frame being drawn (incremented directly by PROF_COUNT)
+extern uint32_t profiler_counters[PROF_NUM_COUNTERS];
+
+void profiler_init(void);
+void profiler_begin(profiler_phase_t phase);
+void profiler_end(profiler_phase_t phase);
+
+// Latch the finished frame and print a summary over stdio every
+// PROFILER_REPORT_FRAMES frames
+void profiler_frame_end(void);
+
+// clk_sys changed (clock governor): convert cycles at the new rate and
+// restart the report window so no average mixes two clocks
+void profiler_clock_changed(void);
+
+// Results of the last finished frame
+uint32_t profiler_frame_us(void);
+uint32_t profiler_phase_us(profiler_phase_t phase);
+uint32_t profiler_count(profiler_counter_t counter);
+const char* profiler_phase_name(profiler_phase_t phase);
+
+#define PROF_BEGIN(phase)     profiler_begin(phase)
+#define PROF_END(phase)       profiler_end(phase)
+#define PROF_COUNT(counter, n) (profiler_counters[(counter)] += (uint32_t)(n))
+
+#else
+
+#define PROF_BEGIN(phase)      ((void)0)
+#define PROF_END(phase)        ((void)0)
+#define PROF_COUNT(counter, n) ((void)0)
+
+#endif // THUMBYCOLOR_PROFILER
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // THUMBYCOLOR_PROFILER_H
@@ -0,0 +1,183 @@
+/*
+ * ThumbyColor Input Record/Replay Implementation
+ *
+ * Stream layout (little endian, in the replay flash region):
+ *   replay_header_t    magic, version, seed, run/frame counts, cart data
+ *   replay_run_t[]     button bitmask + number of consecutive frames
+ */
+
+#include "thumbycolor_replay.h"
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include <stdio.h>
+#include <string.h>
+
+#define REPLAY_MAGIC   0x4C505248  // "HRPL"
+#define REPLAY_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seed;
+    uint32_t num_runs;
+    uint32_t num_frames;
+    int32_t cart_data[64];
+} replay_header_t;
+
+typedef struct {
+    uint16_t buttons;
+    uint16_t frames;
+} replay_run_t;
+
+// Header and runs back to back, as stored in flash
+typedef struct {
+    replay_header_t header;
+    replay_run_t runs[REPLAY_MAX_RUNS];
+} replay_stream_t;
+
+_Static_assert(sizeof(replay_stream_t) <= REPLAY_FLASH_SIZE, "replay stream does not fit its flash region");
+
+static replay_mode_t mode = REPLAY_OFF;
+
+// Recording: stream built in RAM, padded so whole pages can be programmed
+static union {
+    replay_stream_t stream;
+    uint8_t bytes[(sizeof(replay_stream_t) + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE];
+} record_buf __attribute__((aligned(4)));
+
+// Playback: stream read in place from flash (XIP)
+static const replay_stream_t *play_stream = NULL;
+static uint32_t play_run = 0;
+static uint32_t play_run_frame = 0;
+
+static uint32_t frames = 0;
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+void replay_init(uint32_t *seed) {
+    frames = 0;
+
+#if defined(THUMBYCOLOR_REPLAY_RECORD)
+    memset(&record_buf.stream.header, 0, sizeof(record_buf.stream.header));
+    record_buf.stream.header.magic = REPLAY_MAGIC;
+    record_buf.stream.header.version = REPLAY_VERSION;
+    record_buf.stream.header.seed = *seed;
+    mode = REPLAY_RECORDING;
+    printf("replay: recording, seed %08lx\n", (unsigned long)*seed);
+#elif defined(THUMBYCOLOR_REPLAY_PLAY)
+    const replay_stream_t *stream = (const replay_stream_t *)(XIP_BASE + REPLAY_FLASH_OFFSET);
+    if (stream->header.magic != REPLAY_MAGIC || stream->header.version != REPLAY_VERSION ||
+        stream->header.num_runs == 0 || stream->header.num_runs > REPLAY_MAX_RUNS) {
+        printf("replay: no stream in flash, using live input\n");
+        mode = REPLAY_OFF;
+        return;
+    }
+    play_stream = stream;
+    play_run = 0;
+    play_run_frame = 0;
+    *seed = stream->header.seed;
+    mode = REPLAY_PLAYING;
+    printf("replay: playing %lu frames, seed %08lx\n",
+           (unsigned long)stream->header.num_frames, (unsigned long)*seed);
+#else
+    (void)seed;
+#endif
+}
+
+void replay_cart_data(int32_t *cart_data, size_t size) {
+    if (size > sizeof(record_buf.stream.header.cart_data)) size = sizeof(record_buf.stream.header.cart_data);
+    if (mode == REPLAY_RECORDING) {
+        memcpy(record_buf.stream.header.cart_data, cart_data, size);
+    } else if (mode == REPLAY_PLAYING) {
+        memcpy(cart_data, play_stream->header.cart_data, size);
+    }
+}
+
+uint32_t replay_buttons(uint32_t live_buttons) {
+    if (mode == REPLAY_RECORDING) {
+        replay_header_t *h = &record_buf.stream.header;
+        replay_run_t *last = h->num_runs ? &record_buf.stream.runs[h->num_runs - 1] : NULL;
+        if (last && last->buttons == (uint16_t)live_buttons && last->frames < UINT16_MAX) {
+            last->frames++;
+        } else if (h->num_runs < REPLAY_MAX_RUNS) {
+            record_buf.stream.runs[h->num_runs].buttons = (uint16_t)live_buttons;
+            record_buf.stream.runs[h->num_runs].frames = 1;
+            h->num_runs++;
+        } else {
+            return live_buttons;  // Full: caller stops the recording
+        }
+        h->num_frames++;
+        frames++;
+        return live_buttons;
+    }
+
+    if (mode == REPLAY_PLAYING) {
+        const replay_run_t *run = &play_stream->runs[play_run];
+        uint32_t buttons = run->buttons;
+        frames++;
+        if (++play_run_frame >= run->frames) {
+            play_run_frame = 0;
+            if (++play_run >= play_stream->header.num_runs) {
+                printf("replay: finished after %lu frames, back to live input\n", (unsigned long)frames);
+                mode = REPLAY_OFF;
+            }
+        }
+        return buttons;
+    }
+
+    return live_buttons;
+}
+
+replay_mode_t replay_get_mode(void) {
+    return mode;
+}
+
+uint32_t replay_frame_count(void) {
+    return frames;
+}
+
+bool replay_full(void) {
+    return mode == REPLAY_RECORDING && record_buf.stream.header.num_runs >= REPLAY_MAX_RUNS;
+}
+
+// =============================================================================
+// Saving the Recording
+// =============================================================================
+
+static size_t stream_size(void) {
+    return sizeof(replay_header_t) + record_buf.stream.header.num_runs * sizeof(replay_run_t);
+}
+
+static void flash_write_replay(void *param) {
+    (void)param;
+    size_t size = stream_size();
+    size_t erase = (size + FLASH_SECTOR_SIZE - 1) & ~(size_t)(FLASH_SECTOR_SIZE - 1);
+    size_t program = (size + FLASH_PAGE_SIZE - 1) & ~(size_t)(FLASH_PAGE_SIZE - 1);
+    flash_range_erase(REPLAY_FLASH_OFFSET, erase);
+    flash_range_program(REPLAY_FLASH_OFFSET, record_buf.bytes, program);
+}
+
+void replay_stop(void) {
+    if (mode != REPLAY_RECORDING) return;
+    mode = REPLAY_OFF;
+
+    printf("replay: recorded %lu frames in %lu runs\n",
+           (unsigned long)record_buf.stream.header.num_frames, (unsigned long)record_buf.stream.header.num_runs);
+
+    if (flash_safe_execute(flash_write_replay, NULL, UINT32_MAX) != PICO_OK) {
+        printf("replay: flash write failed\n");
+    }
+
+    // Hex dump of the raw stream, to keep recordings off-device
+    const uint8_t *p = record_buf.bytes;
+    size_t size = stream_size();
+    printf("replay-begin %u\n", (unsigned)size);
+    for (size_t i = 0; i < size; i += 32) {
+        for (size_t j = i; j < i + 32 && j < size; j++) printf("%02x", p[j]);
+        printf("\n");
+    }
+    printf("replay-end\n");
+}
@@ -0,0 +1,65 @@
+/*
+ * ThumbyColor Input Record/Replay
+ * Deterministic replays of a session for performance regression runs
+ *
+ * A session is fully determined by rnd_state at game_init(), the cart data
+ * loaded from flash (options, best score) and the button bitmask returned to
+ * update_buttons() every frame. Record mode captures those into a run-length
+ * encoded stream in RAM; when it stops, the stream is written to the replay
+ * flash region and dumped over USB stdio. Play mode feeds the stream from
+ * flash back in place of thumbycolor_get_buttons().
+ *
+ * Selected at build time with -DREPLAY=RECORD or -DREPLAY=PLAY.
+ */
+
+#ifndef THUMBYCOLOR_REPLAY_H
+#define THUMBYCOLOR_REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "thumbycolor_save.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Flash region holding one recorded stream, directly below the save journal
+#define REPLAY_FLASH_SIZE   (32 * 1024)
+#define REPLAY_FLASH_OFFSET (SAVE_FLASH_OFFSET - REPLAY_FLASH_SIZE)
+
+// Button runs kept in RAM while recording (4 bytes each)
+#define REPLAY_MAX_RUNS 4096
+
+typedef enum {
+    REPLAY_OFF,        // Live input (no stream in flash, or playback finished)
+    REPLAY_RECORDING,
+    REPLAY_PLAYING
+} replay_mode_t;
+
+// Start recording, or load the stream from flash and replace *seed with the
+// recorded rnd_state. Call before game_init().
+void replay_init(uint32_t *seed);
+
+// Call at the end of load_cart_data(): recording snapshots the loaded data,
+// playback overwrites it with the recorded snapshot
+void replay_cart_data(int32_t *cart_data, size_t size);
+
+// Per-frame input filter for update_buttons()
+uint32_t replay_buttons(uint32_t live_buttons);
+
+replay_mode_t replay_get_mode(void);
+uint32_t replay_frame_count(void);
+
+// Recording buffer has no room for another run
+bool replay_full(void);
+
+// Stop recording, write the stream to flash and dump it over stdio.
+// The caller must make sure no display DMA is in flight.
+void replay_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // THUMBYCOLOR_REPLAY_H
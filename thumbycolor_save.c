@@ -0,0 +1,296 @@
+/*
+ * ThumbyColor Save Journal Implementation
+ *
+ * Journal layout (little endian, in the save flash region):
+ *   sector[SAVE_JOURNAL_SECTORS]   ring, written page by page
+ *     save_page_t[16]              one record per 256-byte page, 0xFF when erased
+ *
+ * A record holds up to SAVE_PAGE_ENTRIES (index, value) pairs and a sequence
+ * number that grows with every page written. A snapshot is a run of records
+ * (parts 1..N) listing every non-zero entry; entries it does not list are 0.
+ * Loading takes the newest complete snapshot and applies the records after it
+ * in sequence order. A torn page fails its CRC and is skipped, along with the
+ * rest of an incomplete snapshot.
+ */
+
+#include "thumbycolor_save.h"
+#include "thumbycolor_hw.h"
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+#define SAVE_PAGE_MAGIC   0x4A535948  // "HYSJ"
+#define SAVE_LEGACY_MAGIC 0x48595045  // "HYPE"
+
+#define SAVE_PAGES_PER_SECTOR ((int)(FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE))
+#define SAVE_NUM_PAGES        (SAVE_JOURNAL_SECTORS * SAVE_PAGES_PER_SECTOR)
+#define SAVE_PAGE_ENTRIES     30
+
+typedef struct {
+    uint32_t index;
+    int32_t value;
+} save_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint8_t count;           // Entries used
+    uint8_t snapshot_part;   // 1..snapshot_parts, 0 for a plain record
+    uint8_t snapshot_parts;
+    uint8_t reserved;
+    uint32_t crc;            // CRC-32 of the rest of the page
+    save_entry_t entries[SAVE_PAGE_ENTRIES];
+} save_page_t;
+
+_Static_assert(sizeof(save_page_t) == FLASH_PAGE_SIZE, "journal record must fill one flash page");
+
+// Single-sector save of older builds, at the start of the last sector
+typedef struct {
+    uint32_t magic;
+    int32_t data[SAVE_NUM_ENTRIES];
+} save_legacy_t;
+
+static int32_t target[SAVE_NUM_ENTRIES];    // Latest data from save_journal_write()
+static int32_t stored[SAVE_NUM_ENTRIES];    // Data the journal in flash replays to
+
+// Write position
+static uint32_t next_seq = 1;
+static int cur_sector = SAVE_JOURNAL_SECTORS - 1;
+static int next_page = SAVE_PAGES_PER_SECTOR;   // Full: the first write starts sector 0
+
+// Snapshot in progress (snapshot_part != 0) and the data it captures
+static bool snapshot_pending = true;
+static int snapshot_part = 0;
+static int snapshot_parts = 0;
+static int snapshot_next = 0;
+static int32_t snapshot_data[SAVE_NUM_ENTRIES];
+
+static save_page_t page_buf __attribute__((aligned(4)));
+
+// =============================================================================
+// Records
+// =============================================================================
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t len) {
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+    }
+    return crc;
+}
+
+static uint32_t page_crc(const save_page_t *page) {
+    const uint8_t *p = (const uint8_t *)page;
+    uint32_t crc = crc32_update(0xFFFFFFFFu, p, offsetof(save_page_t, crc));
+    crc = crc32_update(crc, p + offsetof(save_page_t, entries), sizeof(page->entries));
+    return ~crc;
+}
+
+static const save_page_t *flash_page(int page) {
+    return (const save_page_t *)(XIP_BASE + SAVE_FLASH_OFFSET + page * FLASH_PAGE_SIZE);
+}
+
+static bool page_valid(const save_page_t *page) {
+    return page->magic == SAVE_PAGE_MAGIC && page->count <= SAVE_PAGE_ENTRIES &&
+           page->snapshot_part <= page->snapshot_parts && page_crc(page) == page->crc;
+}
+
+static bool page_erased(const save_page_t *page) {
+    const uint32_t *w = (const uint32_t *)page;
+    for (size_t i = 0; i < FLASH_PAGE_SIZE / 4; i++) {
+        if (w[i] != 0xFFFFFFFFu) return false;
+    }
+    return true;
+}
+
+static void apply_page(int32_t *data, const save_page_t *page) {
+    for (int i = 0; i < page->count; i++) {
+        if (page->entries[i].index < SAVE_NUM_ENTRIES) data[page->entries[i].index] = page->entries[i].value;
+    }
+}
+
+// Pages needed for a snapshot of data (one even when every entry is 0)
+static int snapshot_pages(const int32_t *data) {
+    int non_zero = 0;
+    for (int i = 0; i < SAVE_NUM_ENTRIES; i++) non_zero += data[i] != 0;
+    return non_zero ? (non_zero + SAVE_PAGE_ENTRIES - 1) / SAVE_PAGE_ENTRIES : 1;
+}
+
+// =============================================================================
+// Loading
+// =============================================================================
+
+bool save_journal_load(int32_t *data) {
+    // Valid pages, sorted by sequence number
+    uint8_t order[SAVE_NUM_PAGES];
+    int count = 0;
+    for (int p = 0; p < SAVE_NUM_PAGES; p++) {
+        const save_page_t *page = flash_page(p);
+        if (!page_valid(page)) continue;
+        int k = count++;
+        while (k > 0 && flash_page(order[k - 1])->seq > page->seq) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = (uint8_t)p;
+    }
+
+    if (count == 0) {
+        const save_legacy_t *legacy = (const save_legacy_t *)(XIP_BASE + PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE);
+        if (legacy->magic != SAVE_LEGACY_MAGIC) return false;
+        memcpy(data, legacy->data, sizeof(legacy->data));
+        memcpy(target, data, sizeof(target));
+        memcpy(stored, data, sizeof(stored));
+        printf("save: migrating single-sector save to the journal\n");
+        return true;
+    }
+
+    // Newest snapshot whose parts all made it to flash
+    int start = 0, start_parts = 0;
+    for (int k = count - 1; k >= 0; k--) {
+        const save_page_t *last = flash_page(order[k]);
+        int parts = last->snapshot_parts;
+        if (last->snapshot_part == 0 || last->snapshot_part != parts || k + 1 < parts) continue;
+        bool complete = true;
+        for (int j = 1; j < parts && complete; j++) {
+            const save_page_t *part = flash_page(order[k - j]);
+            complete = part->seq == last->seq - j && part->snapshot_part == parts - j && part->snapshot_parts == parts;
+        }
+        if (complete) {
+            start = k - parts + 1;
+            start_parts = parts;
+            break;
+        }
+    }
+
+    memset(data, 0, SAVE_NUM_ENTRIES * sizeof(int32_t));
+    for (int k = start; k < count; k++) {
+        // Parts of a later, torn snapshot would mix in values of a save
+        // that never completed
+        const save_page_t *page = flash_page(order[k]);
+        if (page->snapshot_part == 0 || k < start + start_parts) apply_page(data, page);
+    }
+    memcpy(target, data, sizeof(target));
+    memcpy(stored, data, sizeof(stored));
+
+    // Append after the last programmed page of the newest sector. Until that
+    // sector holds a complete snapshot, the next write is one, so the sector
+    // after it can be erased safely.
+    const save_page_t *newest = flash_page(order[count - 1]);
+    next_seq = newest->seq + 1;
+    cur_sector = order[count - 1] / SAVE_PAGES_PER_SECTOR;
+    next_page = SAVE_PAGES_PER_SECTOR;
+    while (next_page > 0 && page_erased(flash_page(cur_sector * SAVE_PAGES_PER_SECTOR + next_page - 1))) next_page--;
+    snapshot_pending = order[start] / SAVE_PAGES_PER_SECTOR != cur_sector || flash_page(order[start])->snapshot_part == 0;
+    return true;
+}
+
+// =============================================================================
+// Writing
+// =============================================================================
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *data;   // NULL: erase the sector at offset
+} save_flash_op_t;
+
+static void flash_do_op(void *param) {
+    const save_flash_op_t *op = (const save_flash_op_t *)param;
+    if (op->data) {
+        flash_range_program(op->offset, op->data, FLASH_PAGE_SIZE);
+    } else {
+        flash_range_erase(op->offset, FLASH_SECTOR_SIZE);
+    }
+}
+
+static bool flash_run_op(uint32_t offset, const void *data) {
+    save_flash_op_t op = { offset, (const uint8_t *)data };
+    if (flash_safe_execute(flash_do_op, &op, UINT32_MAX) != PICO_OK) {
+        printf("save: flash write failed\n");
+        return false;
+    }
+    return true;
+}
+
+void save_journal_write(const int32_t *data) {
+    memcpy(target, data, sizeof(target));
+}
+
+bool save_journal_busy(void) {
+    return snapshot_part != 0 || memcmp(target, stored, sizeof(stored)) != 0;
+}
+
+void save_journal_service(void) {
+    if (!save_journal_busy()) return;
+
+    if (snapshot_part == 0) {
+        int pages = snapshot_pending ? snapshot_pages(target) : 1;
+        if (next_page + pages > SAVE_PAGES_PER_SECTOR) {
+            // Move on to the oldest sector: the snapshot at the start of the
+            // sector after it covers everything it holds
+            int sector = (cur_sector + 1) % SAVE_JOURNAL_SECTORS;
+            // The erase keeps interrupts off for ~45 ms (up to ~400 ms),
+            // far longer than an audio block: hold the buzzer silent rather
+            // than loop the last two blocks
+            thumbycolor_audio_mute(true);
+            bool erased = flash_run_op(SAVE_FLASH_OFFSET + sector * FLASH_SECTOR_SIZE, NULL);
+            thumbycolor_audio_mute(false);
+            if (!erased) return;
+            cur_sector = sector;
+            next_page = 0;
+            snapshot_pending = true;
+            return;
+        }
+        if (snapshot_pending) {
+            memcpy(snapshot_data, target, sizeof(snapshot_data));
+            snapshot_parts = pages;
+            snapshot_part = 1;
+            snapshot_next = 0;
+        }
+    }
+
+    memset(&page_buf, 0xFF, sizeof(page_buf));
+    page_buf.magic = SAVE_PAGE_MAGIC;
+    page_buf.seq = next_seq;
+    page_buf.count = 0;
+    page_buf.snapshot_part = (uint8_t)snapshot_part;
+    page_buf.snapshot_parts = (uint8_t)snapshot_parts;
+    page_buf.reserved = 0;
+    int scan = snapshot_next;
+    if (snapshot_part) {
+        for (; scan < SAVE_NUM_ENTRIES && page_buf.count < SAVE_PAGE_ENTRIES; scan++) {
+            if (snapshot_data[scan] == 0) continue;
+            page_buf.entries[page_buf.count].index = scan;
+            page_buf.entries[page_buf.count].value = snapshot_data[scan];
+            page_buf.count++;
+        }
+    } else {
+        page_buf.snapshot_parts = 0;
+        for (int i = 0; i < SAVE_NUM_ENTRIES && page_buf.count < SAVE_PAGE_ENTRIES; i++) {
+            if (target[i] == stored[i]) continue;
+            page_buf.entries[page_buf.count].index = i;
+            page_buf.entries[page_buf.count].value = target[i];
+            page_buf.count++;
+        }
+    }
+    page_buf.crc = page_crc(&page_buf);
+
+    uint32_t offset = SAVE_FLASH_OFFSET + (cur_sector * SAVE_PAGES_PER_SECTOR + next_page) * FLASH_PAGE_SIZE;
+    if (!flash_run_op(offset, &page_buf)) return;
+    next_page++;
+    next_seq++;
+
+    if (snapshot_part == 0) {
+        apply_page(stored, &page_buf);
+    } else if (snapshot_part < snapshot_parts) {
+        snapshot_part++;
+        snapshot_next = scan;
+    } else {
+        memcpy(stored, snapshot_data, sizeof(stored));
+        snapshot_part = 0;
+        snapshot_pending = false;
+    }
+}
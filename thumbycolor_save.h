@@ -0,0 +1,57 @@
+/*
+ * ThumbyColor Save Journal
+ * Wear-leveled cart data storage at the end of flash
+ *
+ * Rather than erasing and rewriting one sector on every save, the cart data
+ * entries that changed are appended to a journal, one 256-byte page program
+ * per record. The journal is a ring of SAVE_JOURNAL_SECTORS sectors: a sector
+ * is erased only when the journal moves into it, and every sector starts
+ * with a snapshot of the whole cart data, so the oldest sector can always be
+ * dropped.
+ *
+ * Saving only queues the change in RAM. The flash work is done by
+ * save_journal_service(), one page program or sector erase per call, from
+ * the main loop between frames.
+ */
+
+#ifndef THUMBYCOLOR_SAVE_H
+#define THUMBYCOLOR_SAVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Journal region: the last sectors of flash. The last one also holds the
+// single-sector save format of older builds, which is read once and then
+// migrated into the journal on the first save.
+#define SAVE_JOURNAL_SECTORS 4
+#define SAVE_FLASH_SIZE   (SAVE_JOURNAL_SECTORS * FLASH_SECTOR_SIZE)
+#define SAVE_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - SAVE_FLASH_SIZE)
+
+// Entries of cart_data[]
+#define SAVE_NUM_ENTRIES 64
+
+// Replay the journal into data[SAVE_NUM_ENTRIES]. Leaves data untouched and
+// returns false when flash holds no save.
+bool save_journal_load(int32_t *data);
+
+// Queue data[SAVE_NUM_ENTRIES] for saving; only entries that differ from
+// what is already in flash get written
+void save_journal_write(const int32_t *data);
+
+// Queued flash work remains
+bool save_journal_busy(void);
+
+// Do at most one flash operation of the queued work. Interrupts are off and
+// core 1 is parked while it runs, so the caller must make sure no display
+// DMA is in flight.
+void save_journal_service(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // THUMBYCOLOR_SAVE_H
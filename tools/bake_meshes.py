@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""
+Bake the Hyperspace meshes into const C tables.
+
+Decodes the mesh stream in hyperspace_map (hyperspace_data.h) exactly the way
+decode_mesh() in hyperspace_game.h does at boot - same byte layout, same
+libfixmath rounding for the scale multiply and the normal divide - and writes
+hyperspace_meshes.h with flash-resident vertex/triangle tables, plus a
+simplified level of detail of each enemy mesh (HYPERSPACE_MESH_LOD).
+
+Usage:
+    python3 tools/bake_meshes.py hyperspace_data.h hyperspace_game.h out.h
+"""
+
+import re
+import sys
+
+NUM_MESHES = 5  # ship + 4 enemy types, stored back to back from map address 0
+
+
+def f16(x):
+    # F16() from fix16.h
+    return int(x * 65536.0 + 0.5) if x >= 0 else int(x * 65536.0 - 0.5)
+
+
+def fix16_mul(a, b):
+    # fix16_mul() with FIXMATH_NO_OVERFLOW, rounding enabled
+    product = a * b
+    if product < 0:
+        product -= 1
+    return (product >> 16) + ((product & 0x8000) >> 15)
+
+
+def fix16_div(a, b):
+    # fix16_div(): truncates toward zero, b == 0 gives fix16_minimum
+    if b == 0:
+        return -0x80000000
+    q = (abs(a) << 16) // abs(b)
+    return -q if (a < 0) != (b < 0) else q
+
+
+def parse_map(path):
+    text = open(path).read()
+    m = re.search(r"hyperspace_map\s*\[[^\]]*\]\s*=\s*\{(.*?)\};", text, re.S)
+    if not m:
+        sys.exit("bake_meshes: hyperspace_map not found in " + path)
+    return [int(v, 0) for v in re.findall(r"0x[0-9a-fA-F]+|\d+", m.group(1))]
+
+
+def parse_scales(path):
+    text = open(path).read()
+    m = re.search(r"nme_scale\s*\[\s*4\s*\]\s*=\s*\{(.*?)\};", text, re.S)
+    if not m:
+        sys.exit("bake_meshes: nme_scale not found in " + path)
+    scales = [f16(float(v)) for v in re.findall(r"F16\(\s*([-0-9.]+)\s*\)", m.group(1))]
+    if len(scales) != 4:
+        sys.exit("bake_meshes: expected 4 nme_scale entries")
+    return scales
+
+
+class Decoder:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def _signed(self):
+        res = self.data[self.pos]
+        self.pos += 1
+        return res - 256 if res >= 128 else res
+
+    def byte(self):
+        # decode_byte(): signed byte * 0.5 as fix16
+        return (self._signed() << 16) >> 1
+
+    def byte_int(self):
+        # decode_byte_int(): C division truncates toward zero
+        return int(self._signed() / 2)
+
+    def mesh(self, scale):
+        nb_vert = min(max(self.byte_int(), 0), 256)
+        verts = []
+        for _ in range(nb_vert):
+            verts.append(tuple(fix16_mul(self.byte(), scale) for _ in range(3)))
+
+        nb_tri = min(max(self.byte_int(), 0), 256)
+        tris = []
+        for _ in range(nb_tri):
+            idx, normal, uv = [], [], []
+            for _ in range(3):
+                idx.append(self.byte_int() - 1)
+                normal.append(fix16_div(self.byte(), f16(63.5)))
+                uv.append((self.byte(), self.byte()))
+            tris.append((idx, normal, uv))
+        return verts, tris
+
+
+def collapse(tris, keep, drop):
+    # Move vertex drop onto keep; triangles that lose an edge disappear
+    res = []
+    for idx, normal, uv in tris:
+        idx = [keep if j == drop else j for j in idx]
+        if len(set(idx)) == 3:
+            res.append((idx, normal, uv))
+    return res
+
+
+def simplify(verts, tris):
+    # Shortest-edge collapses down to half the triangles. A collapse may not
+    # leave fewer than 4 triangles or two on the same vertices (a closed
+    # mesh stays closed), and vertex 0 is never removed: auto-aim reads it.
+    # Surviving triangles keep their winding, normal and texture corners.
+    target = (len(tris) + 1) // 2
+    while len(tris) > target:
+        best = None
+        for idx, _, _ in tris:
+            for k in range(3):
+                a, b = idx[k], idx[(k + 1) % 3]
+                for keep, drop in ((a, b), (b, a)):
+                    if drop == 0:
+                        continue
+                    res = collapse(tris, keep, drop)
+                    faces = [frozenset(t[0]) for t in res]
+                    if len(res) < 4 or len(set(faces)) != len(faces):
+                        continue
+                    dist = sum((verts[keep][c] - verts[drop][c]) ** 2 for c in range(3))
+                    if best is None or dist < best[0]:
+                        best = (dist, res)
+        if best is None:
+            break
+        tris = best[1]
+
+    # Compact the vertices still in use, in their original order
+    used = sorted({0} | {j for t in tris for j in t[0]})
+    remap = {j: i for i, j in enumerate(used)}
+    return ([verts[j] for j in used],
+            [([remap[j] for j in idx], normal, uv) for idx, normal, uv in tris])
+
+
+def fx(v):
+    return "%d" % v
+
+
+def vec3(v):
+    return "{%s, %s, %s}" % (fx(v[0]), fx(v[1]), fx(v[2]))
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    data = parse_map(sys.argv[1])
+    scales = [f16(1.0)] + parse_scales(sys.argv[2])
+
+    dec = Decoder(data)
+    meshes = [dec.mesh(scales[i]) for i in range(NUM_MESHES)]
+
+    out = []
+    out.append("/*")
+    out.append(" * Hyperspace baked meshes")
+    out.append(" * Auto-generated by tools/bake_meshes.py from hyperspace_data.h - do not edit")
+    out.append(" */")
+    out.append("")
+    out.append("#ifndef HYPERSPACE_MESHES_H")
+    out.append("#define HYPERSPACE_MESHES_H")
+    out.append("")
+    out.append("// Included from hyperspace_game.h after Vec3/Triangle/Mesh are defined")
+    out.append("")
+    for i, (verts, tris) in enumerate(meshes):
+        if not verts or not tris:
+            sys.exit("bake_meshes: mesh %d is empty" % i)
+        for t in tris:
+            if any(j < 0 or j >= len(verts) for j in t[0]):
+                sys.exit("bake_meshes: mesh %d has an out-of-range vertex index" % i)
+        out.append("// Mesh %d: %d vertices, %d triangles, scale %s"
+                   % (i, len(verts), len(tris), fx(scales[i])))
+        out.append("static const Vec3 baked_mesh%d_vertices[%d] = {" % (i, len(verts)))
+        for v in verts:
+            out.append("    %s," % vec3(v))
+        out.append("};")
+        out.append("static const Triangle baked_mesh%d_triangles[%d] = {" % (i, len(tris)))
+        for idx, normal, uv in tris:
+            out.append("    {.tri = {%d, %d, %d}, .uv = {{%s, %s}, {%s, %s}, {%s, %s}}, .normal = %s},"
+                       % (idx[0], idx[1], idx[2],
+                          fx(uv[0][0]), fx(uv[0][1]), fx(uv[1][0]), fx(uv[1][1]),
+                          fx(uv[2][0]), fx(uv[2][1]), vec3(normal)))
+        out.append("};")
+        out.append("static Vec3 baked_mesh%d_projected[%d];" % (i, len(verts)))
+        out.append("")
+
+    lods = [simplify(verts, tris) for verts, tris in meshes[1:]]
+    for i, (verts, tris) in enumerate(lods, 1):
+        if len(tris) == len(meshes[i][1]):
+            out.append("// Mesh %d LOD: too small to simplify, same as the full mesh" % i)
+            out.append("")
+            continue
+        out.append("// Mesh %d LOD: %d vertices, %d triangles" % (i, len(verts), len(tris)))
+        out.append("static const Vec3 baked_mesh%d_lod_vertices[%d] = {" % (i, len(verts)))
+        for v in verts:
+            out.append("    %s," % vec3(v))
+        out.append("};")
+        out.append("static const Triangle baked_mesh%d_lod_triangles[%d] = {" % (i, len(tris)))
+        for idx, normal, uv in tris:
+            out.append("    {.tri = {%d, %d, %d}, .uv = {{%s, %s}, {%s, %s}, {%s, %s}}, .normal = %s},"
+                       % (idx[0], idx[1], idx[2],
+                          fx(uv[0][0]), fx(uv[0][1]), fx(uv[1][0]), fx(uv[1][1]),
+                          fx(uv[2][0]), fx(uv[2][1]), vec3(normal)))
+        out.append("};")
+        out.append("")
+
+    out.append("#define BAKED_NME_MAX_VERTICES %d" % max(len(v) for v, _ in meshes[1:]))
+    out.append("#define BAKED_NME_MAX_TRIANGLES %d" % max(len(t) for _, t in meshes[1:]))
+    out.append("")
+    out.append("static const Mesh baked_meshes[%d] = {" % NUM_MESHES)
+    for i, (verts, tris) in enumerate(meshes):
+        out.append("    {baked_mesh%d_vertices, baked_mesh%d_projected, baked_mesh%d_triangles, %d, %d},"
+                   % (i, i, i, len(verts), len(tris)))
+    out.append("};")
+    out.append("")
+    out.append("// Enemy meshes 1..4 at the simplified level of detail (projected into the")
+    out.append("// enemy's own buffer, like the full meshes)")
+    out.append("static const Mesh baked_nme_lod_meshes[%d] = {" % len(lods))
+    for i, (verts, tris) in enumerate(lods, 1):
+        name = "baked_mesh%d" % i if len(tris) == len(meshes[i][1]) else "baked_mesh%d_lod" % i
+        out.append("    {%s_vertices, NULL, %s_triangles, %d, %d}," % (name, name, len(verts), len(tris)))
+    out.append("};")
+    out.append("")
+    out.append("#endif // HYPERSPACE_MESHES_H")
+    out.append("")
+
+    with open(sys.argv[3], "w") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+Report where the hot code and data landed in a GNU ld map file.
+
+Reads the input sections of the linked image (hyperspace_thumbycolor.elf.map
+as written by pico_add_extra_outputs()) and prints, for every tracked hot
+function and buffer, the memory region it was placed in, followed by the
+totals per region. Run by the RAM_HOT_PATHS build after linking.
+
+Usage:
+    python3 tools/ram_report.py hyperspace_thumbycolor.elf.map
+"""
+
+import re
+import sys
+
+# RP2350 address map
+REGIONS = [
+    ("flash", 0x10000000, 0x20000000),
+    ("SRAM", 0x20000000, 0x20080000),
+    ("scratch X", 0x20080000, 0x20081000),
+    ("scratch Y", 0x20081000, 0x20082000),
+]
+
+# Hot paths, by input section name suffix (-ffunction-sections /
+# -fdata-sections, or the __not_in_flash_func / __scratch_x name)
+TRACKED = [
+    # Projection and rasterizer (hyperspace_game.h)
+    "transform_pos", "transform_points",
+    "texmap_scanline", "rasterize_flat_tri", "rasterize_tri", "rq_draw",
+    # libfixmath
+    "fix16_mul", "fix16_div", "fix16_div_fast", "fix16_recip", "fix16_recip_seed",
+    "fix16_sqrt", "fix16_sin", "fix16_cos", "fix16_sincos", "_fix16_sin_quarter",
+    # Display and audio IRQ paths (thumbycolor_hw.c)
+    "display_prepare_chunk", "display_arm_chunk", "display_chunk_done",
+    "display_dma_irq_handler", "audio_mix_pair", "audio_render_pair",
+    "audio_render_block", "audio_dma_irq_handler",
+    # Buffers
+    "pico8_palette", "pico8_pairs", "screen_buffers", "spritesheet",
+    "display_line_buffers",
+]
+
+SECTION_RE = re.compile(r"^ (\.[^\s*]\S*)(?:\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(\S.*))?$")
+PLACEMENT_RE = re.compile(r"^\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(\S.*)$")
+
+
+def region_of(addr):
+    for name, lo, hi in REGIONS:
+        if lo <= addr < hi:
+            return name
+    return None
+
+
+def parse_map(path):
+    # Input sections of the memory map: (section, address, size, object).
+    # Long section names put the address on the following line.
+    sections = []
+    in_map = False
+    pending = None
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not in_map:
+                in_map = line.startswith("Linker script and memory map")
+                continue
+            if pending:
+                m = PLACEMENT_RE.match(line)
+                if m:
+                    sections.append((pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3)))
+                pending = None
+                continue
+            m = SECTION_RE.match(line)
+            if not m:
+                continue
+            if m.group(2) is None:
+                pending = m.group(1)
+            else:
+                sections.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)))
+    return sections
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    sections = [s for s in parse_map(sys.argv[1]) if s[2] > 0 and region_of(s[1])]
+
+    print("RAM placement report (%s)" % sys.argv[1])
+    print("  %-24s %-10s %-10s %6s" % ("symbol", "region", "address", "bytes"))
+    for name in TRACKED:
+        found = [s for s in sections if s[0].rsplit(".", 1)[-1] == name]
+        for section, addr, size, _ in found:
+            print("  %-24s %-10s 0x%08x %6d" % (name, region_of(addr), addr, size))
+        if not found:
+            # Inlined into its caller, or a backend that is not built
+            print("  %-24s -" % name)
+
+    totals = {}
+    for _, addr, size, _ in sections:
+        region = region_of(addr)
+        totals[region] = totals.get(region, 0) + size
+    for name, lo, hi in REGIONS:
+        capacity = "" if name == "flash" else " / %d" % (hi - lo)
+        print("  %-10s %7d%s bytes" % (name, totals.get(name, 0), capacity))
+
+
+if __name__ == "__main__":
+    main()